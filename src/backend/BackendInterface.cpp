@@ -5,13 +5,25 @@ namespace Backend {
 bool
 BackendInterface::finishWrites(std::uint32_t const ledgerSequence)
 {
-    auto commitRes = doFinishWrites();
+    auto commitRes = doFinishWrites(ledgerSequence);
     if (commitRes)
     {
         updateRange(ledgerSequence);
     }
     return commitRes;
 }
+bool
+BackendInterface::advanceRange(
+    std::uint32_t const maxSequence,
+    std::uint32_t const prevMaxSequence)
+{
+    auto commitRes = doAdvanceRange(maxSequence, prevMaxSequence);
+    if (commitRes)
+    {
+        updateRange(maxSequence);
+    }
+    return commitRes;
+}
 void
 BackendInterface::writeLedgerObject(
     std::string&& key,
@@ -297,8 +309,6 @@ BackendInterface::fetchFees(
     std::uint32_t const seq,
     boost::asio::yield_context& yield) const
 {
-    ripple::Fees fees;
-
     auto key = ripple::keylet::fees().key;
     auto bytes = fetchLedgerObject(key, seq, yield);
 
@@ -308,22 +318,7 @@ BackendInterface::fetchFees(
         return {};
     }
 
-    ripple::SerialIter it(bytes->data(), bytes->size());
-    ripple::SLE sle{it, key};
-
-    if (sle.getFieldIndex(ripple::sfBaseFee) != -1)
-        fees.base = sle.getFieldU64(ripple::sfBaseFee);
-
-    if (sle.getFieldIndex(ripple::sfReferenceFeeUnits) != -1)
-        fees.units = sle.getFieldU32(ripple::sfReferenceFeeUnits);
-
-    if (sle.getFieldIndex(ripple::sfReserveBase) != -1)
-        fees.reserve = sle.getFieldU32(ripple::sfReserveBase);
-
-    if (sle.getFieldIndex(ripple::sfReserveIncrement) != -1)
-        fees.increment = sle.getFieldU32(ripple::sfReserveIncrement);
-
-    return fees;
+    return deserializeFees(*bytes);
 }
 
 }  // namespace Backend
@@ -2,6 +2,8 @@
 #define RIPPLE_APP_REPORTING_BACKENDINTERFACE_H_INCLUDED
 
 #include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/json.hpp>
 #include <boost/log/trivial.hpp>
 
@@ -11,6 +13,7 @@
 #include <backend/SimpleCache.h>
 #include <backend/Types.h>
 
+#include <future>
 #include <thread>
 #include <type_traits>
 
@@ -46,15 +49,165 @@ retryOnTimeout(F func, size_t waitMs = 500)
     }
 }
 
+namespace detail {
+
+/// Threads that run the backend coroutines spawned with spawnFuture. Started
+/// on first use, with one thread per core
+class SynchronousPool
+{
+    boost::asio::io_context ioc_;
+    std::optional<boost::asio::io_context::work> work_;
+    std::vector<std::thread> threads_;
+
+    SynchronousPool(std::size_t numThreads)
+    {
+        work_.emplace(ioc_);
+        for (auto i = numThreads; i > 0; --i)
+            threads_.emplace_back([this]() { ioc_.run(); });
+    }
+
+public:
+    ~SynchronousPool()
+    {
+        work_.reset();
+        ioc_.stop();
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+    static SynchronousPool&
+    instance()
+    {
+        static SynchronousPool pool{
+            std::max(4u, std::thread::hardware_concurrency())};
+        return pool;
+    }
+
+    boost::asio::io_context&
+    context()
+    {
+        return ioc_;
+    }
+};
+
+/// The io_context synchronous runs coroutines on, kept for the life of the
+/// calling thread. depth is the number of calls to synchronous running on
+/// the thread. A nested call can't run the io_context again, so it gets one
+/// of its own
+struct ThreadContext
+{
+    boost::asio::io_context ctx;
+    int depth = 0;
+};
+
+inline ThreadContext&
+threadContext()
+{
+    thread_local ThreadContext context;
+    return context;
+}
+
+}  // namespace detail
+
+/// Run f(yield) in a coroutine on the shared pool of detail::SynchronousPool
+/// and return a future of its result, so that the caller can do other work,
+/// or start other fetches, while it runs. An exception thrown by f, such as
+/// DatabaseTimeout, is rethrown by the get() of the future. f is moved or
+/// copied into the coroutine
+template <class F>
+auto
+spawnFuture(F&& f)
+{
+    using Yield = boost::asio::yield_context;
+    using R = std::invoke_result_t<std::decay_t<F>&, Yield&>;
+
+    auto promise = std::make_shared<std::promise<R>>();
+    auto future = promise->get_future();
+    boost::asio::spawn(
+        boost::asio::make_strand(
+            detail::SynchronousPool::instance().context()),
+        [f = std::forward<F>(f),
+         promise](boost::asio::yield_context yield) mutable {
+            try
+            {
+                if constexpr (std::is_same_v<R, void>)
+                {
+                    f(yield);
+                    promise->set_value();
+                }
+                else
+                {
+                    promise->set_value(f(yield));
+                }
+            }
+            catch (boost::coroutines::detail::forced_unwind const&)
+            {
+                // the pool is being destroyed
+                throw;
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+    return future;
+}
+
+/// spawnFuture, retrying f until it doesn't time out. The coroutine waits
+/// between tries without blocking a thread of the pool
+template <class F>
+auto
+spawnFutureAndRetryOnTimeout(F&& f, size_t waitMs = 500)
+{
+    return spawnFuture([f = std::forward<F>(f),
+                        waitMs](boost::asio::yield_context yield) mutable {
+        while (true)
+        {
+            try
+            {
+                return f(yield);
+            }
+            catch (DatabaseTimeout& t)
+            {
+                BOOST_LOG_TRIVIAL(error)
+                    << "spawnFutureAndRetryOnTimeout"
+                    << " Database request timed out. Waiting and retrying ... ";
+                boost::asio::steady_timer timer{
+                    detail::SynchronousPool::instance().context(),
+                    std::chrono::milliseconds(waitMs)};
+                timer.async_wait(yield);
+            }
+        }
+    });
+}
+
+/// Run f(yield) in a coroutine on the calling thread, and wait for its
+/// result
 template <class F>
 auto
 synchronous(F&& f)
 {
-    boost::asio::io_context ctx;
+    auto& thread = detail::threadContext();
+    std::optional<boost::asio::io_context> nested;
+    auto& ctx = thread.depth ? nested.emplace() : thread.ctx;
+
+    struct Depth
+    {
+        int& depth;
+        Depth(int& d) : depth(++d)
+        {
+        }
+        ~Depth()
+        {
+            --depth;
+        }
+    } depth{thread.depth};
+
     boost::asio::io_context::strand strand(ctx);
     std::optional<boost::asio::io_context::work> work;
 
     work.emplace(ctx);
+    ctx.restart();
 
     using R = typename std::result_of<F(boost::asio::yield_context&)>::type;
     if constexpr (!std::is_same<R, void>::value)
@@ -327,7 +480,10 @@ public:
     startWrites() const = 0;
 
     // Tell the database we have finished writing all data for a particular
-    // ledger
+    // ledger. This waits for the writes of this ledger and of every ledger
+    // before it, but not for writes of later ledgers, so the caller may keep
+    // writing subsequent ledgers from another thread while this commits.
+    // Ledgers must be committed in order
     // TODO change the return value to represent different results. committed,
     // write conflict, errored, successful but not committed
     bool
@@ -338,6 +494,32 @@ public:
         std::uint32_t numLedgersToKeep,
         boost::asio::yield_context& yield) const = 0;
 
+    virtual OnlineDeleteStatus
+    getOnlineDeleteStatus() const = 0;
+
+    // Wait for the in flight writes of the ledgers in [minSequence,
+    // maxSequence] to finish. Writes of other ledgers are not waited for
+    virtual void
+    syncLedgers(
+        std::uint32_t const minSequence,
+        std::uint32_t const maxSequence) const = 0;
+
+    // Move the most recent ledger in the database from prevMaxSequence to
+    // maxSequence in a single step. Every ledger in between must already be
+    // written. Returns false if another process changed the range
+    bool
+    advanceRange(
+        std::uint32_t const maxSequence,
+        std::uint32_t const prevMaxSequence);
+
+    // Record that every ledger in range has been written, so an interrupted
+    // backfill does not need to write them again
+    virtual void
+    writeBackfillProgress(LedgerRange const& range) const = 0;
+
+    virtual std::vector<LedgerRange>
+    fetchBackfillProgress(boost::asio::yield_context& yield) const = 0;
+
     // Open the database. Set up all of the necessary objects and
     // datastructures. After this call completes, the database is ready for
     // use.
@@ -360,7 +542,12 @@ private:
         std::string&& blob) = 0;
 
     virtual bool
-    doFinishWrites() = 0;
+    doFinishWrites(std::uint32_t const ledgerSequence) = 0;
+
+    virtual bool
+    doAdvanceRange(
+        std::uint32_t const maxSequence,
+        std::uint32_t const prevMaxSequence) = 0;
 };
 
 }  // namespace Backend
@@ -63,13 +63,20 @@ struct WriteCallbackData
     std::uint32_t currentRetries;
     std::atomic<int> refs = 1;
     std::string id;
+    // ledger whose commit has to wait for this write. Bulk writes belong to
+    // no ledger, and are only counted by their own BulkWriteCallbackData
+    std::optional<std::uint32_t> ledgerSequence;
 
     WriteCallbackData(
         CassandraBackend const* b,
+        std::optional<std::uint32_t> const seq,
         T&& d,
         B bind,
         std::string const& identifier)
-        : backend(b), data(std::move(d)), id(identifier)
+        : backend(b)
+        , data(std::move(d))
+        , id(identifier)
+        , ledgerSequence(seq)
     {
         retry = [bind, this](auto& params, bool isRetry) {
             auto statement = bind(params);
@@ -90,7 +97,7 @@ struct WriteCallbackData
     virtual void
     finish()
     {
-        backend->finishAsyncWrite();
+        backend->finishAsyncWrite(*ledgerSequence);
         int remaining = --refs;
         if (remaining == 0)
             delete this;
@@ -119,7 +126,7 @@ struct BulkWriteCallbackData : public WriteCallbackData<T, B>
         std::atomic_int& r,
         std::mutex& m,
         std::condition_variable& c)
-        : WriteCallbackData<T, B>(b, std::move(d), bind, "bulk")
+        : WriteCallbackData<T, B>(b, {}, std::move(d), bind, "bulk")
         , numRemaining(r)
         , mtx(m)
         , cv(c)
@@ -128,7 +135,7 @@ struct BulkWriteCallbackData : public WriteCallbackData<T, B>
     void
     start() override
     {
-        this->retry(*this, true);
+        this->retry(*this, false);
     }
 
     void
@@ -136,8 +143,10 @@ struct BulkWriteCallbackData : public WriteCallbackData<T, B>
     {
         // TODO: it would be nice to avoid this lock.
         std::lock_guard lck(mtx);
-        if (--numRemaining == 0)
-            cv.notify_one();
+        --numRemaining;
+        // waiters may be waiting for numRemaining to drop below a limit, not
+        // just for it to reach 0
+        cv.notify_all();
     }
     ~BulkWriteCallbackData()
     {
@@ -148,11 +157,12 @@ template <class T, class B>
 void
 makeAndExecuteAsyncWrite(
     CassandraBackend const* b,
+    std::uint32_t const seq,
     T&& d,
     B bind,
     std::string const& id)
 {
-    auto* cb = new WriteCallbackData<T, B>(b, std::move(d), bind, id);
+    auto* cb = new WriteCallbackData<T, B>(b, seq, std::move(d), bind, id);
     cb->start();
 }
 template <class T, class B>
@@ -180,6 +190,7 @@ CassandraBackend::doWriteLedgerObject(
     if (range)
         makeAndExecuteAsyncWrite(
             this,
+            seq,
             std::make_tuple(seq, key),
             [this](auto& params) {
                 auto& [sequence, key] = params.data;
@@ -190,8 +201,28 @@ CassandraBackend::doWriteLedgerObject(
                 return statement;
             },
             "ledger_diff");
+    if (latestObjectsTable_)
+        makeAndExecuteAsyncWrite(
+            this,
+            seq,
+            std::make_tuple(key, seq, blob),
+            [this](auto& params) {
+                auto& [key, sequence, blob] = params.data;
+
+                // the write timestamp is the ledger sequence, so a row can
+                // never be overwritten by an older version of the object,
+                // regardless of the order in which writes land
+                CassandraStatement statement{insertLatestObject_};
+                statement.bindNextBytes(key);
+                statement.bindNextInt(sequence);
+                statement.bindNextBytes(blob);
+                statement.bindNextInt(sequence);
+                return statement;
+            },
+            "latest_ledger_object");
     makeAndExecuteAsyncWrite(
         this,
+        seq,
         std::make_tuple(std::move(key), seq, std::move(blob)),
         [this](auto& params) {
             auto& [key, sequence, blob] = params.data;
@@ -217,6 +248,7 @@ CassandraBackend::writeSuccessor(
     assert(successor.size() != 0);
     makeAndExecuteAsyncWrite(
         this,
+        seq,
         std::make_tuple(std::move(key), seq, std::move(successor)),
         [this](auto& params) {
             auto& [key, sequence, successor] = params.data;
@@ -234,8 +266,30 @@ CassandraBackend::writeLedger(
     ripple::LedgerInfo const& ledgerInfo,
     std::string&& header)
 {
+    // The latest objects table is only complete since the first ledger
+    // written by a writer that maintains it, with no ledger in between
+    // written by one that does not. A writer that maintains the table marks
+    // it complete since its first ledger, unless it already is. One that
+    // does not clears the mark, so that the rows it leaves stale are not
+    // read. Both are done before the first ledger is committed
+    if (!latestObjectsMarked_.exchange(true))
+    {
+        if (latestObjectsTable_)
+        {
+            CassandraStatement statement{insertLatestObjectsSince_};
+            statement.bindNextInt(ledgerInfo.seq);
+            executeSyncWrite(statement);
+        }
+        else
+        {
+            CassandraStatement statement{deleteLatestObjectsSince_};
+            executeSyncWrite(statement);
+        }
+    }
+
     makeAndExecuteAsyncWrite(
         this,
+        ledgerInfo.seq,
         std::make_tuple(ledgerInfo.seq, std::move(header)),
         [this](auto& params) {
             auto& [sequence, header] = params.data;
@@ -247,6 +301,7 @@ CassandraBackend::writeLedger(
         "ledger");
     makeAndExecuteAsyncWrite(
         this,
+        ledgerInfo.seq,
         std::make_tuple(ledgerInfo.hash, ledgerInfo.seq),
         [this](auto& params) {
             auto& [hash, sequence] = params.data;
@@ -256,7 +311,6 @@ CassandraBackend::writeLedger(
             return statement;
         },
         "ledger_hash");
-    ledgerSequence_ = ledgerInfo.seq;
 }
 
 void
@@ -269,6 +323,7 @@ CassandraBackend::writeAccountTransactions(
         {
             makeAndExecuteAsyncWrite(
                 this,
+                record.ledgerSequence,
                 std::make_tuple(
                     std::move(account),
                     record.ledgerSequence,
@@ -294,6 +349,7 @@ CassandraBackend::writeNFTTransactions(std::vector<NFTTransactionsData>&& data)
     {
         makeAndExecuteAsyncWrite(
             this,
+            record.ledgerSequence,
             std::make_tuple(
                 record.tokenID,
                 record.ledgerSequence,
@@ -320,20 +376,27 @@ CassandraBackend::writeTransaction(
     std::string&& metadata)
 {
     BOOST_LOG_TRIVIAL(trace) << "Writing txn to cassandra";
-    std::string hashCpy = hash;
 
+    // the transaction is stored twice: clustered under its ledger, so a whole
+    // ledger can be read from one partition, and by hash, for tx lookups
     makeAndExecuteAsyncWrite(
         this,
-        std::make_pair(seq, hash),
+        seq,
+        std::make_tuple(seq, hash, date, transaction, metadata),
         [this](auto& params) {
             CassandraStatement statement{insertLedgerTransaction_};
-            statement.bindNextInt(params.data.first);
-            statement.bindNextBytes(params.data.second);
+            auto& [sequence, hash, date, transaction, metadata] = params.data;
+            statement.bindNextInt(sequence);
+            statement.bindNextBytes(hash);
+            statement.bindNextInt(date);
+            statement.bindNextBytes(transaction);
+            statement.bindNextBytes(metadata);
             return statement;
         },
         "ledger_transaction");
     makeAndExecuteAsyncWrite(
         this,
+        seq,
         std::make_tuple(
             std::move(hash),
             seq,
@@ -360,6 +423,7 @@ CassandraBackend::writeNFTs(std::vector<NFTsData>&& data)
     {
         makeAndExecuteAsyncWrite(
             this,
+            record.ledgerSequence,
             std::make_tuple(
                 record.tokenID,
                 record.ledgerSequence,
@@ -378,6 +442,7 @@ CassandraBackend::writeNFTs(std::vector<NFTsData>&& data)
 
         makeAndExecuteAsyncWrite(
             this,
+            record.ledgerSequence,
             std::make_tuple(record.tokenID),
             [this](auto const& params) {
                 CassandraStatement statement{insertIssuerNFT_};
@@ -420,30 +485,113 @@ CassandraBackend::fetchAllTransactionsInLedger(
     std::uint32_t const ledgerSequence,
     boost::asio::yield_context& yield) const
 {
-    auto hashes = fetchAllTransactionHashesInLedger(ledgerSequence, yield);
-    return fetchTransactions(hashes, yield);
+    CassandraStatement statement{selectAllTransactionsInLedger_};
+    statement.bindNextInt(ledgerSequence);
+    auto start = std::chrono::system_clock::now();
+
+    CassandraResult result = executeAsyncRead(statement, yield);
+
+    auto end = std::chrono::system_clock::now();
+    if (!result)
+    {
+        BOOST_LOG_TRIVIAL(error)
+            << __func__
+            << " - no rows . ledger = " << std::to_string(ledgerSequence);
+        return {};
+    }
+
+    // ledgers written before transactions were stored in ledger_transactions
+    // only have the hash there. Those are fetched from transactions
+    std::vector<TransactionAndMetadata> txns;
+    std::vector<std::size_t> missing;
+    std::vector<ripple::uint256> missingHashes;
+    do
+    {
+        auto hash = result.getUInt256();
+        if (result.isNull())
+        {
+            missing.push_back(txns.size());
+            missingHashes.push_back(hash);
+            txns.push_back({});
+            continue;
+        }
+        auto date = result.getUInt32();
+        auto transaction = result.getBlob();
+        auto metadata = result.getBlob();
+        txns.push_back({
+            std::move(transaction),
+            std::move(metadata),
+            ledgerSequence,
+            date});
+    } while (result.nextRow());
+
+    if (missingHashes.size())
+    {
+        auto fetched = fetchTransactions(missingHashes, yield);
+        for (std::size_t i = 0; i < missing.size(); ++i)
+            txns[missing[i]] = std::move(fetched[i]);
+    }
+
+    BOOST_LOG_TRIVIAL(debug)
+        << "Fetched " << txns.size() << " transactions in ledger "
+        << std::to_string(ledgerSequence) << " from Cassandra in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
+               .count()
+        << " milliseconds. " << missingHashes.size()
+        << " were fetched by hash";
+    return txns;
 }
 
-template <class Result>
-struct ReadCallbackData
+// Shared state for a fan-out of point reads issued from one coroutine. The
+// results and the per-request slots are sized up front and live on the
+// stack of the suspended coroutine, so issuing N reads performs no per-read
+// heap allocation beyond the statements themselves. OnSuccess is a concrete
+// callable type rather than a std::function, so parsing a row into its
+// result slot is a direct call.
+//
+// The statements can not be shared: cass_session_execute keeps a reference
+// to the bound statement until the request is written, so rebinding one for
+// the next key would race with the driver's I/O thread.
+template <class Result, class T, class OnSuccess>
+struct BatchReadCallbackData
 {
     using handler_type = typename Result::completion_handler_type;
 
-    std::atomic_int& numOutstanding;
-    handler_type handler;
-    std::function<void(CassandraResult&)> onSuccess;
+    // cass_future_set_callback only carries a single void*, so each request
+    // gets a slot that knows which result it is filling
+    struct Slot
+    {
+        BatchReadCallbackData* batch;
+        std::size_t index;
+    };
 
+    handler_type handler;
+    OnSuccess onSuccess;
+    std::vector<T> results;
+    std::vector<Slot> slots;
+    std::atomic_size_t numOutstanding;
     std::atomic_bool errored = false;
-    ReadCallbackData(
-        std::atomic_int& numOutstanding,
+
+    BatchReadCallbackData(
         handler_type& handler,
-        std::function<void(CassandraResult&)> onSuccess)
-        : numOutstanding(numOutstanding), handler(handler), onSuccess(onSuccess)
+        OnSuccess onSuccess,
+        std::size_t const numRequests)
+        : handler(handler)
+        , onSuccess(std::move(onSuccess))
+        , results(numRequests)
+        , numOutstanding(numRequests)
     {
+        slots.reserve(numRequests);
+        for (std::size_t i = 0; i < numRequests; ++i)
+            slots.push_back({this, i});
     }
 
+    BatchReadCallbackData(BatchReadCallbackData const&) = delete;
+    BatchReadCallbackData&
+    operator=(BatchReadCallbackData const&) = delete;
+
     void
-    finish(CassFuture* fut)
+    finish(std::size_t const index, CassFuture* fut)
     {
         CassError rc = cass_future_error_code(fut);
         if (rc != CASS_OK)
@@ -453,7 +601,8 @@ struct ReadCallbackData
         else
         {
             CassandraResult result{cass_future_get_result(fut)};
-            onSuccess(result);
+            if (result.hasResult())
+                onSuccess(result, results[index]);
         }
 
         if (--numOutstanding == 0)
@@ -471,65 +620,92 @@ struct ReadCallbackData
     }
 };
 
+template <class Batch>
 void
-processAsyncRead(CassFuture* fut, void* cbData)
+processAsyncBatchRead(CassFuture* fut, void* cbData)
 {
-    ReadCallbackData<result_type>& cb =
-        *static_cast<ReadCallbackData<result_type>*>(cbData);
-    cb.finish(fut);
+    auto& slot = *static_cast<typename Batch::Slot*>(cbData);
+    slot.batch->finish(slot.index, fut);
 }
 
-std::vector<TransactionAndMetadata>
-CassandraBackend::fetchTransactions(
-    std::vector<ripple::uint256> const& hashes,
+template <class T, class OnSuccess>
+auto
+makeBatchReadCallbackData(
+    handler_type& handler,
+    OnSuccess&& onSuccess,
+    std::size_t const numRequests)
+{
+    return BatchReadCallbackData<
+        result_type,
+        T,
+        typename std::decay<OnSuccess>::type>(
+        handler, std::forward<OnSuccess>(onSuccess), numRequests);
+}
+
+template <class T, class MakeStatement, class OnSuccess>
+std::vector<T>
+CassandraBackend::executeBatchRead(
+    std::size_t const numRequests,
+    MakeStatement&& makeStatement,
+    OnSuccess&& onSuccess,
     boost::asio::yield_context& yield) const
 {
-    if (hashes.size() == 0)
+    if (numRequests == 0)
         return {};
-    numReadRequestsOutstanding_ += hashes.size();
+    numReadRequestsOutstanding_ += numRequests;
 
     handler_type handler(std::forward<decltype(yield)>(yield));
     result_type result(handler);
 
-    std::size_t const numHashes = hashes.size();
-    std::atomic_int numOutstanding = numHashes;
-    std::vector<TransactionAndMetadata> results{numHashes};
-    std::vector<std::shared_ptr<ReadCallbackData<result_type>>> cbs;
-    cbs.reserve(numHashes);
-    auto start = std::chrono::system_clock::now();
+    auto batch = makeBatchReadCallbackData<T>(
+        handler, std::forward<OnSuccess>(onSuccess), numRequests);
+    using batch_type = decltype(batch);
 
-    for (std::size_t i = 0; i < hashes.size(); ++i)
+    for (std::size_t i = 0; i < numRequests; ++i)
     {
-        CassandraStatement statement{selectTransaction_};
-        statement.bindNextBytes(hashes[i]);
-
-        cbs.push_back(std::make_shared<ReadCallbackData<result_type>>(
-            numOutstanding, handler, [i, &results](auto& result) {
-                if (result.hasResult())
-                    results[i] = {
-                        result.getBytes(),
-                        result.getBytes(),
-                        result.getUInt32(),
-                        result.getUInt32()};
-            }));
-
-        executeAsyncRead(statement, processAsyncRead, *cbs[i]);
+        CassandraStatement statement = makeStatement(i);
+        executeAsyncRead(
+            statement, processAsyncBatchRead<batch_type>, batch.slots[i]);
     }
-    assert(results.size() == cbs.size());
 
     // suspend the coroutine until completion handler is called.
     result.get();
-    numReadRequestsOutstanding_ -= hashes.size();
+    numReadRequestsOutstanding_ -= numRequests;
+
+    if (batch.errored)
+        throw DatabaseTimeout();
+
+    return std::move(batch.results);
+}
+
+std::vector<TransactionAndMetadata>
+CassandraBackend::fetchTransactions(
+    std::vector<ripple::uint256> const& hashes,
+    boost::asio::yield_context& yield) const
+{
+    if (hashes.size() == 0)
+        return {};
 
+    auto start = std::chrono::system_clock::now();
+    auto results = executeBatchRead<TransactionAndMetadata>(
+        hashes.size(),
+        [this, &hashes](std::size_t const i) {
+            CassandraStatement statement{selectTransaction_};
+            statement.bindNextBytes(hashes[i]);
+            return statement;
+        },
+        [](CassandraResult& result, TransactionAndMetadata& txn) {
+            txn = {
+                result.getBlob(),
+                result.getBlob(),
+                result.getUInt32(),
+                result.getUInt32()};
+        },
+        yield);
     auto end = std::chrono::system_clock::now();
-    for (auto const& cb : cbs)
-    {
-        if (cb->errored)
-            throw DatabaseTimeout();
-    }
 
     BOOST_LOG_TRIVIAL(debug)
-        << "Fetched " << numHashes << " transactions from Cassandra in "
+        << "Fetched " << hashes.size() << " transactions from Cassandra in "
         << std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
                .count()
         << " milliseconds";
@@ -788,6 +964,28 @@ CassandraBackend::doFetchLedgerObject(
     boost::asio::yield_context& yield) const
 {
     BOOST_LOG_TRIVIAL(trace) << "Fetching from cassandra";
+    if (auto const since = latestObjectsSince(sequence, yield))
+    {
+        CassandraStatement statement{selectLatestObject_};
+        statement.bindNextBytes(key);
+
+        CassandraResult result = executeAsyncRead(statement, yield);
+        if (result)
+        {
+            auto res = result.getBlob();
+            // the row may already hold a version newer than sequence, if the
+            // next ledger is being written, or be stale, if it was written
+            // before the table was last complete. Then fall back to objects
+            auto const rowSequence = result.getUInt32();
+            if (rowSequence >= *since && rowSequence <= sequence)
+            {
+                if (res.size())
+                    return res;
+                return {};
+            }
+        }
+    }
+
     CassandraStatement statement{selectObject_};
     statement.bindNextBytes(key);
     statement.bindNextInt(sequence);
@@ -799,12 +997,63 @@ CassandraBackend::doFetchLedgerObject(
         BOOST_LOG_TRIVIAL(debug) << __func__ << " - no rows";
         return {};
     }
-    auto res = result.getBytes();
+    auto res = result.getBlob();
     if (res.size())
         return res;
     return {};
 }
 
+std::optional<std::uint32_t>
+CassandraBackend::latestObjectsSince(
+    std::uint32_t const sequence,
+    boost::asio::yield_context& yield) const
+{
+    if (!latestObjectsTable_)
+        return {};
+
+    auto const rng = fetchLedgerRange();
+    if (!rng || sequence != rng->maxSequence)
+        return {};
+
+    {
+        std::lock_guard lck{latestObjectsMtx_};
+        if (latestObjectsCheckedAt_ == rng->maxSequence)
+            return latestObjectsSince_;
+    }
+
+    std::optional<std::uint32_t> since;
+    CassandraStatement statement{selectLatestObjectsSince_};
+    CassandraResult result = executeAsyncRead(statement, yield);
+    if (result)
+        since = result.getUInt32();
+
+    std::lock_guard lck{latestObjectsMtx_};
+    if (latestObjectsCheckedAt_ < rng->maxSequence)
+    {
+        latestObjectsCheckedAt_ = rng->maxSequence;
+        latestObjectsSince_ = since;
+    }
+    return since;
+}
+
+std::vector<Blob>
+CassandraBackend::fetchObjectsFromHistory(
+    std::vector<ripple::uint256> const& keys,
+    std::uint32_t const sequence,
+    boost::asio::yield_context& yield) const
+{
+    return executeBatchRead<Blob>(
+        keys.size(),
+        [this, &keys, sequence](std::size_t const i) {
+            CassandraStatement statement{selectObject_};
+            statement.bindNextBytes(keys[i]);
+            statement.bindNextInt(sequence);
+            return statement;
+        },
+        [](CassandraResult& result, Blob& blob) { blob = result.getBlob(); },
+        yield);
+}
+
 std::vector<Blob>
 CassandraBackend::doFetchLedgerObjects(
     std::vector<ripple::uint256> const& keys,
@@ -814,44 +1063,65 @@ CassandraBackend::doFetchLedgerObjects(
     if (keys.size() == 0)
         return {};
 
-    numReadRequestsOutstanding_ += keys.size();
-
-    handler_type handler(std::forward<decltype(yield)>(yield));
-    result_type result(handler);
-
     std::size_t const numKeys = keys.size();
     BOOST_LOG_TRIVIAL(trace)
         << "Fetching " << numKeys << " records from Cassandra";
-    std::atomic_int numOutstanding = numKeys;
-    std::vector<Blob> results{numKeys};
-    std::vector<std::shared_ptr<ReadCallbackData<result_type>>> cbs;
-    cbs.reserve(numKeys);
-    for (std::size_t i = 0; i < keys.size(); ++i)
+
+    auto const since = latestObjectsSince(sequence, yield);
+    if (!since)
     {
-        cbs.push_back(std::make_shared<ReadCallbackData<result_type>>(
-            numOutstanding, handler, [i, &results](auto& result) {
-                if (result.hasResult())
-                    results[i] = result.getBytes();
-            }));
-        CassandraStatement statement{selectObject_};
-        statement.bindNextBytes(keys[i]);
-        statement.bindNextInt(sequence);
-        executeAsyncRead(statement, processAsyncRead, *cbs[i]);
+        auto results = fetchObjectsFromHistory(keys, sequence, yield);
+        BOOST_LOG_TRIVIAL(trace)
+            << "Fetched " << numKeys << " records from Cassandra";
+        return results;
     }
-    assert(results.size() == cbs.size());
 
-    // suspend the coroutine until completion handler is called.
-    result.get();
-    numReadRequestsOutstanding_ -= keys.size();
+    struct LatestObject
+    {
+        Blob blob;
+        std::optional<std::uint32_t> sequence;
+    };
+    auto latest = executeBatchRead<LatestObject>(
+        numKeys,
+        [this, &keys](std::size_t const i) {
+            CassandraStatement statement{selectLatestObject_};
+            statement.bindNextBytes(keys[i]);
+            return statement;
+        },
+        [](CassandraResult& result, LatestObject& obj) {
+            obj.blob = result.getBlob();
+            obj.sequence = result.getUInt32();
+        },
+        yield);
+
+    // keys without a usable row (not written since the table is complete,
+    // or already overwritten by the ledger being written) go to objects
+    std::vector<Blob> results;
+    results.reserve(numKeys);
+    std::vector<std::size_t> missing;
+    for (std::size_t i = 0; i < numKeys; ++i)
+    {
+        if (!latest[i].sequence || *latest[i].sequence < *since ||
+            *latest[i].sequence > sequence)
+            missing.push_back(i);
+        results.push_back(std::move(latest[i].blob));
+    }
 
-    for (auto const& cb : cbs)
+    if (missing.size())
     {
-        if (cb->errored)
-            throw DatabaseTimeout();
+        std::vector<ripple::uint256> missingKeys;
+        missingKeys.reserve(missing.size());
+        for (auto const i : missing)
+            missingKeys.push_back(keys[i]);
+
+        auto objs = fetchObjectsFromHistory(missingKeys, sequence, yield);
+        for (std::size_t j = 0; j < missing.size(); ++j)
+            results[missing[j]] = std::move(objs[j]);
     }
 
     BOOST_LOG_TRIVIAL(trace)
-        << "Fetched " << numKeys << " records from Cassandra";
+        << "Fetched " << numKeys << " records from Cassandra. "
+        << missing.size() << " were not in the latest objects table";
     return results;
 }
 
@@ -898,22 +1168,176 @@ CassandraBackend::fetchLedgerDiff(
     return results;
 }
 
-bool
-CassandraBackend::doOnlineDelete(
-    std::uint32_t const numLedgersToKeep,
+std::vector<CassandraBackend::OnlineDeleteRange>
+CassandraBackend::fetchOnlineDeleteProgress(
+    LedgerRange const& range,
     boost::asio::yield_context& yield) const
 {
-    // calculate TTL
-    // ledgers close roughly every 4 seconds. We double the TTL so that way
-    // there is a window of time to update the database, to prevent unchanging
-    // records from being deleted.
-    auto rng = fetchLedgerRange();
-    if (!rng)
-        return false;
-    std::uint32_t minLedger = rng->maxSequence - numLedgersToKeep;
-    if (minLedger <= rng->minSequence)
-        return false;
-    auto bind = [this](auto& params) {
+    CassandraStatement statement{selectOnlineDeleteProgress_};
+    CassandraResult result = executeAsyncRead(statement, yield);
+    if (!result)
+        return {};
+
+    std::vector<OnlineDeleteRange> ranges;
+    do
+    {
+        OnlineDeleteRange r;
+        r.index = result.getUInt32();
+        r.minLedger = result.getUInt32();
+        r.start = result.getUInt256();
+        r.end = result.getUInt256();
+        r.cursor = result.getUInt256();
+        r.done = result.getBool();
+        ranges.push_back(r);
+    } while (result.nextRow());
+
+    // the table is never cleared, so only the ranges of the most recent online
+    // delete are relevant. If the ledger range was already advanced past that
+    // online delete, it completed and there is nothing to resume
+    std::uint32_t const latest =
+        std::max_element(
+            ranges.begin(),
+            ranges.end(),
+            [](auto const& a, auto const& b) {
+                return a.minLedger < b.minLedger;
+            })
+            ->minLedger;
+    if (latest <= range.minSequence || latest > range.maxSequence)
+        return {};
+
+    ranges.erase(
+        std::remove_if(
+            ranges.begin(),
+            ranges.end(),
+            [latest](auto const& r) { return r.minLedger != latest; }),
+        ranges.end());
+    std::sort(ranges.begin(), ranges.end(), [](auto const& a, auto const& b) {
+        return a.index < b.index;
+    });
+    for (std::size_t i = 0; i < ranges.size(); ++i)
+    {
+        // a range is missing. Should never happen, start over
+        if (ranges[i].index != i)
+            return {};
+    }
+    return ranges;
+}
+
+void
+CassandraBackend::writeOnlineDeleteProgress(
+    OnlineDeleteRange const& range) const
+{
+    CassandraStatement statement{insertOnlineDeleteProgress_};
+    statement.bindNextInt(static_cast<std::uint32_t>(range.index));
+    statement.bindNextInt(range.minLedger);
+    statement.bindNextBytes(range.start);
+    statement.bindNextBytes(range.end);
+    statement.bindNextBytes(range.cursor);
+    statement.bindNextBoolean(range.done);
+    executeSyncWrite(statement);
+}
+
+void
+CassandraBackend::writeBackfillProgress(LedgerRange const& range) const
+{
+    CassandraStatement statement{insertBackfillProgress_};
+    statement.bindNextInt(range.minSequence);
+    statement.bindNextInt(range.maxSequence);
+    executeSyncWrite(statement);
+}
+
+std::vector<LedgerRange>
+CassandraBackend::fetchBackfillProgress(boost::asio::yield_context& yield) const
+{
+    CassandraStatement statement{selectBackfillProgress_};
+    CassandraResult result = executeAsyncRead(statement, yield);
+    if (!result)
+        return {};
+
+    std::vector<LedgerRange> ranges;
+    do
+    {
+        LedgerRange r;
+        r.minSequence = result.getUInt32();
+        r.maxSequence = result.getUInt32();
+        ranges.push_back(r);
+    } while (result.nextRow());
+    return ranges;
+}
+
+std::vector<CassandraBackend::OnlineDeleteRange>
+CassandraBackend::makeOnlineDeleteRanges(
+    std::uint32_t const minLedger,
+    boost::asio::yield_context& yield) const
+{
+    // Ranges have to start at keys that exist in minLedger, so the successor
+    // table can be walked from there. Keys modified in the ledgers just before
+    // minLedger are spread uniformly across the key space; use the ones that
+    // still exist at minLedger as boundaries
+    std::vector<ripple::uint256> keys;
+    for (std::uint32_t i = 0;
+         i < 8 && i < minLedger && keys.size() < onlineDeleteRanges_ * 4;
+         ++i)
+    {
+        auto diff = retryOnTimeout(
+            [&]() { return fetchLedgerDiff(minLedger - i, yield); });
+        for (auto& obj : diff)
+            keys.push_back(obj.key);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    auto objs = retryOnTimeout(
+        [&]() { return fetchLedgerObjects(keys, minLedger, yield); });
+    std::vector<ripple::uint256> existing;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        if (objs[i].size())
+            existing.push_back(keys[i]);
+    }
+
+    std::size_t const numRanges = std::max<std::size_t>(
+        1, std::min<std::size_t>(onlineDeleteRanges_, existing.size() + 1));
+    std::vector<ripple::uint256> boundaries;
+    boundaries.push_back(firstKey);
+    for (std::size_t i = 1; i < numRanges; ++i)
+        boundaries.push_back(existing[i * existing.size() / numRanges]);
+    boundaries.push_back(lastKey);
+
+    std::vector<OnlineDeleteRange> ranges;
+    for (std::size_t i = 0; i + 1 < boundaries.size(); ++i)
+    {
+        ranges.push_back(
+            {i, minLedger, boundaries[i], boundaries[i + 1], boundaries[i]});
+    }
+    return ranges;
+}
+
+void
+CassandraBackend::throttleOnlineDelete(std::size_t const bytes) const
+{
+    if (!onlineDeleteBytesPerSecond_)
+        return;
+
+    std::chrono::steady_clock::time_point wakeup;
+    {
+        std::lock_guard lck(onlineDeleteMtx_);
+        auto const now = std::chrono::steady_clock::now();
+        if (onlineDeleteNextWrite_ < now)
+            onlineDeleteNextWrite_ = now;
+        wakeup = onlineDeleteNextWrite_;
+        onlineDeleteNextWrite_ += std::chrono::microseconds(
+            bytes * 1000000 / onlineDeleteBytesPerSecond_);
+    }
+    std::this_thread::sleep_until(wakeup);
+}
+
+void
+CassandraBackend::onlineDeleteRange(
+    OnlineDeleteRange& range,
+    boost::asio::yield_context& yield) const
+{
+    auto bindObject = [this](auto& params) {
         auto& [key, seq, obj] = params.data;
         CassandraStatement statement{insertObject_};
         statement.bindNextBytes(key);
@@ -921,52 +1345,199 @@ CassandraBackend::doOnlineDelete(
         statement.bindNextBytes(obj);
         return statement;
     };
+    auto bindSuccessor = [this](auto& params) {
+        auto& [key, seq, next] = params.data;
+        CassandraStatement statement{insertSuccessor_};
+        statement.bindNextBytes(key);
+        statement.bindNextInt(seq);
+        statement.bindNextBytes(next);
+        return statement;
+    };
+    using object_data = std::tuple<ripple::uint256, std::uint32_t, Blob>;
+    using successor_data =
+        std::tuple<ripple::uint256, std::uint32_t, ripple::uint256>;
+
     std::condition_variable cv;
     std::mutex mtx;
-    std::vector<std::shared_ptr<BulkWriteCallbackData<
-        std::tuple<ripple::uint256, std::uint32_t, Blob>,
-        typename std::remove_reference<decltype(bind)>::type>>>
-        cbs;
-    std::uint32_t concurrentLimit = 10;
     std::atomic_int numOutstanding = 0;
+    std::vector<std::shared_ptr<void>> cbs;
 
-    // iterate through latest ledger, updating TTL
-    std::optional<ripple::uint256> cursor;
-    while (true)
+    auto waitFor = [&](int limit) {
+        std::unique_lock<std::mutex> lck(mtx);
+        cv.wait(lck, [&numOutstanding, limit]() {
+            return numOutstanding <= limit;
+        });
+    };
+    auto writeSuccessor = [&](ripple::uint256 const& key,
+                              ripple::uint256 const& next) {
+        ++numOutstanding;
+        cbs.push_back(makeAndExecuteBulkAsyncWrite(
+            this,
+            successor_data{key, range.minLedger, next},
+            bindSuccessor,
+            numOutstanding,
+            mtx,
+            cv));
+        waitFor(onlineDeleteWriteConcurrency_);
+    };
+
+    BOOST_LOG_TRIVIAL(debug)
+        << __func__ << " starting range " << range.index
+        << " at cursor = " << ripple::strHex(range.cursor);
+
+    bool const isLast = range.end == lastKey;
+    // the previous key in the ledger. The successor of the previous key and the
+    // successor of any book base between the previous key and the current key
+    // are rewritten along with each object
+    ripple::uint256 prev = range.cursor;
+    while (!range.done)
     {
-        auto [objects, curCursor] = retryOnTimeout([&]() {
-            return fetchLedgerPage(cursor, minLedger, 256, false, yield);
+        auto [objects, cursor] = retryOnTimeout([&]() {
+            return fetchLedgerPage(
+                range.cursor, range.minLedger, 256, false, yield);
         });
 
+        std::size_t bytes = 0;
+        std::size_t numObjects = 0;
         for (auto& obj : objects)
         {
+            if (obj.key > range.end)
+            {
+                range.done = true;
+                break;
+            }
+
+            writeSuccessor(prev, obj.key);
+            if (isBookDir(obj.key, obj.blob))
+            {
+                auto const bookBase = getBookBase(obj.key);
+                if (prev < bookBase)
+                    writeSuccessor(bookBase, obj.key);
+            }
+            prev = obj.key;
+
+            bytes += obj.blob.size();
+            ++numObjects;
             ++numOutstanding;
             cbs.push_back(makeAndExecuteBulkAsyncWrite(
                 this,
-                std::make_tuple(
-                    std::move(obj.key), minLedger, std::move(obj.blob)),
-                bind,
+                object_data{obj.key, range.minLedger, std::move(obj.blob)},
+                bindObject,
                 numOutstanding,
                 mtx,
                 cv));
-
-            std::unique_lock<std::mutex> lck(mtx);
-            BOOST_LOG_TRIVIAL(trace) << __func__ << "Got the mutex";
-            cv.wait(lck, [&numOutstanding, concurrentLimit]() {
-                return numOutstanding < concurrentLimit;
-            });
+            waitFor(onlineDeleteWriteConcurrency_);
         }
-        BOOST_LOG_TRIVIAL(debug) << __func__ << " fetched a page";
-        cursor = curCursor;
+
         if (!cursor)
-            break;
+        {
+            if (isLast)
+                writeSuccessor(prev, lastKey);
+            range.done = true;
+        }
+        else if (*cursor >= range.end)
+        {
+            range.done = true;
+        }
+
+        // only checkpoint once everything before the cursor is written
+        waitFor(0);
+        cbs.clear();
+        range.cursor = prev;
+        writeOnlineDeleteProgress(range);
+
+        {
+            std::lock_guard lck(onlineDeleteMtx_);
+            onlineDeleteStatus_.objectsWritten += numObjects;
+            onlineDeleteStatus_.bytesWritten += bytes;
+            if (range.done)
+                ++onlineDeleteStatus_.rangesDone;
+        }
+        throttleOnlineDelete(bytes);
+    }
+    BOOST_LOG_TRIVIAL(debug) << __func__ << " finished range " << range.index;
+}
+
+bool
+CassandraBackend::doOnlineDelete(
+    std::uint32_t const numLedgersToKeep,
+    boost::asio::yield_context& yield) const
+{
+    // calculate TTL
+    // ledgers close roughly every 4 seconds. We double the TTL so that way
+    // there is a window of time to update the database, to prevent unchanging
+    // records from being deleted.
+    auto rng = fetchLedgerRange();
+    if (!rng)
+        return false;
+
+    auto ranges = fetchOnlineDeleteProgress(*rng, yield);
+    if (ranges.size())
+    {
+        BOOST_LOG_TRIVIAL(info)
+            << __func__ << " resuming online delete. min ledger = "
+            << ranges.front().minLedger;
+    }
+    else
+    {
+        if (rng->maxSequence <= numLedgersToKeep)
+            return false;
+        std::uint32_t minLedger = rng->maxSequence - numLedgersToKeep;
+        if (minLedger <= rng->minSequence)
+            return false;
+        ranges = makeOnlineDeleteRanges(minLedger, yield);
+        for (auto const& range : ranges)
+            writeOnlineDeleteProgress(range);
+    }
+    std::uint32_t const minLedger = ranges.front().minLedger;
+
+    {
+        std::lock_guard lck(onlineDeleteMtx_);
+        onlineDeleteStatus_ = {};
+        onlineDeleteStatus_.running = true;
+        onlineDeleteStatus_.minLedger = minLedger;
+        onlineDeleteStatus_.numRanges = ranges.size();
+        onlineDeleteStatus_.rangesDone = std::count_if(
+            ranges.begin(), ranges.end(), [](auto const& r) {
+                return r.done;
+            });
+        onlineDeleteStatus_.startTime = std::chrono::system_clock::now();
+    }
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " deleting ledgers before " << minLedger
+        << ". num ranges = " << ranges.size()
+        << ". num workers = " << onlineDeleteWorkers_;
+
+    // rewrite every object and successor in minLedger, refreshing their TTL.
+    // Everything that was only needed by older ledgers then expires
+    std::atomic_size_t nextRange = 0;
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < std::min<std::size_t>(
+                                    onlineDeleteWorkers_, ranges.size());
+         ++i)
+    {
+        workers.emplace_back([this, &ranges, &nextRange]() {
+            synchronous([&](boost::asio::yield_context& yield) {
+                for (std::size_t r = nextRange++; r < ranges.size();
+                     r = nextRange++)
+                    onlineDeleteRange(ranges[r], yield);
+            });
+        });
     }
-    std::unique_lock<std::mutex> lck(mtx);
-    cv.wait(lck, [&numOutstanding]() { return numOutstanding == 0; });
+    for (auto& worker : workers)
+        worker.join();
+
     CassandraStatement statement{deleteLedgerRange_};
     statement.bindNextInt(minLedger);
     executeSyncWrite(statement);
-    // update ledger_range
+
+    {
+        std::lock_guard lck(onlineDeleteMtx_);
+        onlineDeleteStatus_.running = false;
+        onlineDeleteStatus_.endTime = std::chrono::system_clock::now();
+    }
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " finished online delete. min ledger = " << minLedger;
     return true;
 }
 
@@ -1163,6 +1734,26 @@ CassandraBackend::open(bool readOnly)
 
     int rf = getInt("replication_factor") ? *getInt("replication_factor") : 3;
 
+    if (getInt("online_delete_workers"))
+        onlineDeleteWorkers_ = *getInt("online_delete_workers");
+    if (getInt("online_delete_ranges"))
+        onlineDeleteRanges_ = *getInt("online_delete_ranges");
+    if (getInt("online_delete_write_concurrency"))
+        onlineDeleteWriteConcurrency_ =
+            *getInt("online_delete_write_concurrency");
+    if (getInt("online_delete_bytes_per_second"))
+        onlineDeleteBytesPerSecond_ = *getInt("online_delete_bytes_per_second");
+    if (onlineDeleteWorkers_ == 0 || onlineDeleteRanges_ == 0 ||
+        onlineDeleteWriteConcurrency_ == 0)
+        throw std::runtime_error(
+            "online delete workers, ranges and write concurrency must be "
+            "greater than 0");
+
+    latestObjectsTable_ = config_.contains("latest_objects_table") &&
+        config_.at("latest_objects_table").as_bool();
+    BOOST_LOG_TRIVIAL(info) << __func__ << " latest objects table is "
+                            << (latestObjectsTable_ ? "enabled" : "disabled");
+
     std::string tablePrefix = getString("table_prefix");
     if (tablePrefix.empty())
     {
@@ -1255,6 +1846,35 @@ CassandraBackend::open(bool readOnly)
         if (!executeSimpleStatement(query.str()))
             continue;
 
+        // One row per key, holding the most recent version of the object.
+        // Not subject to the ttl, since unchanged objects are never rewritten
+        query.str("");
+        query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
+              << "objects_latest"
+              << " ( key blob PRIMARY KEY, sequence bigint, object blob )";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
+        query.str("");
+        query << "SELECT * FROM " << tablePrefix << "objects_latest"
+              << " LIMIT 1";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
+        // The ledger objects_latest is complete since, if it is maintained
+        query.str("");
+        query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
+              << "objects_latest_since"
+              << " ( is_set boolean PRIMARY KEY, sequence bigint )";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
+        query.str("");
+        query << "SELECT * FROM " << tablePrefix << "objects_latest_since"
+              << " LIMIT 1";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
         query.str("");
         query
             << "CREATE TABLE IF NOT EXISTS " << tablePrefix << "transactions"
@@ -1266,12 +1886,25 @@ CassandraBackend::open(bool readOnly)
         query.str("");
         query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
               << "ledger_transactions"
-              << " ( ledger_sequence bigint, hash blob, PRIMARY "
+              << " ( ledger_sequence bigint, hash blob, date bigint, "
+                 "transaction blob, metadata blob, PRIMARY "
                  "KEY(ledger_sequence, hash))"
               << " WITH default_time_to_live = " << std::to_string(ttl);
         if (!executeSimpleStatement(query.str()))
             continue;
 
+        // ledger_transactions used to only hold hashes. Add the columns to
+        // existing tables; this is rejected as an invalid query, and ignored,
+        // if the columns already exist
+        for (auto const& column :
+             {"date bigint", "transaction blob", "metadata blob"})
+        {
+            query.str("");
+            query << "ALTER TABLE " << tablePrefix << "ledger_transactions"
+                  << " ADD " << column;
+            executeSimpleStatement(query.str());
+        }
+
         query.str("");
         query << "SELECT * FROM " << tablePrefix << "transactions"
               << " LIMIT 1";
@@ -1366,6 +1999,35 @@ CassandraBackend::open(bool readOnly)
         if (!executeSimpleStatement(query.str()))
             continue;
 
+        query.str("");
+        query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
+              << "online_delete_progress"
+              << " (range_index bigint PRIMARY KEY, min_ledger bigint, "
+                 "range_start blob, range_end blob, cursor blob, "
+                 "done boolean)";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
+        query.str("");
+        query << "SELECT * FROM " << tablePrefix << "online_delete_progress"
+              << " LIMIT 1";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
+        query.str("");
+        query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
+              << "backfill_progress"
+              << " (range_start bigint PRIMARY KEY, range_end bigint)"
+              << " WITH default_time_to_live = " << ttl;
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
+        query.str("");
+        query << "SELECT * FROM " << tablePrefix << "backfill_progress"
+              << " LIMIT 1";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
         query.str("");
         query << "CREATE TABLE IF NOT EXISTS " << tablePrefix << "nf_tokens"
               << "  ("
@@ -1446,8 +2108,8 @@ CassandraBackend::open(bool readOnly)
             continue;
         query.str("");
         query << "INSERT INTO " << tablePrefix << "ledger_transactions"
-              << " (ledger_sequence, hash) VALUES "
-                 "(?, ?)";
+              << " (ledger_sequence, hash, date, transaction, metadata) VALUES "
+                 "(?, ?, ?, ?, ?)";
         if (!insertLedgerTransaction_.prepareStatement(query, session_.get()))
             continue;
 
@@ -1483,6 +2145,37 @@ CassandraBackend::open(bool readOnly)
         if (!selectObject_.prepareStatement(query, session_.get()))
             continue;
 
+        query.str("");
+        query << "INSERT INTO " << tablePrefix << "objects_latest"
+              << " (key, sequence, object) VALUES (?, ?, ?)"
+              << " USING TIMESTAMP ?";
+        if (!insertLatestObject_.prepareStatement(query, session_.get()))
+            continue;
+
+        query.str("");
+        query << "SELECT object, sequence FROM " << tablePrefix
+              << "objects_latest WHERE key = ?";
+        if (!selectLatestObject_.prepareStatement(query, session_.get()))
+            continue;
+
+        query.str("");
+        query << "INSERT INTO " << tablePrefix << "objects_latest_since"
+              << " (is_set, sequence) VALUES (true, ?) IF NOT EXISTS";
+        if (!insertLatestObjectsSince_.prepareStatement(query, session_.get()))
+            continue;
+
+        query.str("");
+        query << "DELETE FROM " << tablePrefix << "objects_latest_since"
+              << " WHERE is_set = true";
+        if (!deleteLatestObjectsSince_.prepareStatement(query, session_.get()))
+            continue;
+
+        query.str("");
+        query << "SELECT sequence FROM " << tablePrefix
+              << "objects_latest_since WHERE is_set = true";
+        if (!selectLatestObjectsSince_.prepareStatement(query, session_.get()))
+            continue;
+
         query.str("");
         query << "SELECT transaction, metadata, ledger_sequence, date FROM "
               << tablePrefix << "transactions"
@@ -1497,6 +2190,14 @@ CassandraBackend::open(bool readOnly)
                 query, session_.get()))
             continue;
 
+        query.str("");
+        query << "SELECT hash, date, transaction, metadata FROM "
+              << tablePrefix << "ledger_transactions"
+              << " WHERE ledger_sequence = ?";
+        if (!selectAllTransactionsInLedger_.prepareStatement(
+                query, session_.get()))
+            continue;
+
         query.str("");
         query << "SELECT key FROM " << tablePrefix << "objects "
               << " WHERE TOKEN(key) >= ? and sequence <= ? "
@@ -1638,6 +2339,34 @@ CassandraBackend::open(bool readOnly)
         query << " SELECT sequence FROM " << tablePrefix << "ledger_range";
         if (!selectLedgerRange_.prepareStatement(query, session_.get()))
             continue;
+
+        query.str("");
+        query << "INSERT INTO " << tablePrefix << "online_delete_progress"
+              << " (range_index, min_ledger, range_start, range_end, cursor, "
+                 "done) VALUES (?, ?, ?, ?, ?, ?)";
+        if (!insertOnlineDeleteProgress_.prepareStatement(
+                query, session_.get()))
+            continue;
+
+        query.str("");
+        query << "SELECT range_index, min_ledger, range_start, range_end, "
+                 "cursor, done FROM "
+              << tablePrefix << "online_delete_progress";
+        if (!selectOnlineDeleteProgress_.prepareStatement(
+                query, session_.get()))
+            continue;
+
+        query.str("");
+        query << "INSERT INTO " << tablePrefix << "backfill_progress"
+              << " (range_start, range_end) VALUES (?, ?)";
+        if (!insertBackfillProgress_.prepareStatement(query, session_.get()))
+            continue;
+
+        query.str("");
+        query << "SELECT range_start, range_end FROM " << tablePrefix
+              << "backfill_progress";
+        if (!selectBackfillProgress_.prepareStatement(query, session_.get()))
+            continue;
         setupPreparedStatements = true;
     }
 
@@ -14,6 +14,7 @@
 #include <cassandra.h>
 #include <cstddef>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -144,6 +145,11 @@ public:
         bindNextBytes(data.data(), data.size());
     }
     void
+    bindNextBytes(Blob const& data)
+    {
+        bindNextBytes(data.data(), data.size());
+    }
+    void
     bindNextBytes(ripple::AccountID const& data)
     {
         bindNextBytes(data.data(), data.size());
@@ -330,6 +336,15 @@ public:
         return !hasResult();
     }
 
+    // true if the next column to be read is null (or was never written)
+    bool
+    isNull()
+    {
+        if (!row_)
+            throw std::runtime_error("CassandraResult::isNull - no result");
+        return cass_value_is_null(cass_row_get_column(row_, curGetIndex_));
+    }
+
     size_t
     numRows()
     {
@@ -370,6 +385,29 @@ public:
         return {buf, buf + bufSize};
     }
 
+    // Like getBytes, but the bytes are copied straight out of the driver into
+    // a shared Blob, so every later copy of the result shares one buffer
+    Blob
+    getBlob()
+    {
+        if (!row_)
+            throw std::runtime_error("CassandraResult::getBlob - no result");
+        cass_byte_t const* buf;
+        std::size_t bufSize;
+        CassError rc = cass_value_get_bytes(
+            cass_row_get_column(row_, curGetIndex_), &buf, &bufSize);
+        if (rc != CASS_OK)
+        {
+            std::stringstream msg;
+            msg << "CassandraResult::getBlob - error getting value: " << rc
+                << ", " << cass_error_desc(rc);
+            BOOST_LOG_TRIVIAL(error) << msg.str();
+            throw std::runtime_error(msg.str());
+        }
+        curGetIndex_++;
+        return Blob{buf, buf + bufSize};
+    }
+
     ripple::uint256
     getUInt256()
     {
@@ -614,7 +652,13 @@ private:
     CassandraPreparedStatement insertLedgerTransaction_;
     CassandraPreparedStatement selectTransaction_;
     CassandraPreparedStatement selectAllTransactionHashesInLedger_;
+    CassandraPreparedStatement selectAllTransactionsInLedger_;
     CassandraPreparedStatement selectObject_;
+    CassandraPreparedStatement insertLatestObject_;
+    CassandraPreparedStatement selectLatestObject_;
+    CassandraPreparedStatement insertLatestObjectsSince_;
+    CassandraPreparedStatement deleteLatestObjectsSince_;
+    CassandraPreparedStatement selectLatestObjectsSince_;
     CassandraPreparedStatement selectLedgerPageKeys_;
     CassandraPreparedStatement selectLedgerPage_;
     CassandraPreparedStatement upperBound2_;
@@ -641,6 +685,10 @@ private:
     CassandraPreparedStatement selectLedgerByHash_;
     CassandraPreparedStatement selectLatestLedger_;
     CassandraPreparedStatement selectLedgerRange_;
+    CassandraPreparedStatement insertOnlineDeleteProgress_;
+    CassandraPreparedStatement selectOnlineDeleteProgress_;
+    CassandraPreparedStatement insertBackfillProgress_;
+    CassandraPreparedStatement selectBackfillProgress_;
 
     uint32_t syncInterval_ = 1;
     uint32_t lastSync_ = 0;
@@ -672,7 +720,105 @@ private:
 
     boost::json::object config_;
 
-    mutable std::uint32_t ledgerSequence_ = 0;
+    // number of in flight writes per ledger, guarded by syncMutex_. A ledger
+    // can be committed once neither it nor any earlier ledger has writes in
+    // flight, even if writes of later ledgers are still outstanding
+    mutable std::map<std::uint32_t, std::uint32_t> writesOutstandingByLedger_;
+
+    // when set, the most recent version of every object is also kept in a
+    // single row per key, and reads at the latest ledger are served from there
+    // instead of from the (ever growing) objects partition
+    bool latestObjectsTable_ = false;
+
+    // whether this writer has marked the latest objects table as maintained
+    // (or not) yet, see writeLedger
+    std::atomic_bool latestObjectsMarked_ = false;
+
+    // the ledger the latest objects table is complete since, as last read
+    // from the database, and the latest ledger it was read at
+    mutable std::mutex latestObjectsMtx_;
+    mutable std::uint32_t latestObjectsCheckedAt_ = 0;
+    mutable std::optional<std::uint32_t> latestObjectsSince_;
+
+    // If reads at sequence can be served from the latest objects table, the
+    // ledger the table is complete since. Rows of the table are only valid
+    // if their sequence is at least that, as rows written before the writer
+    // last stopped maintaining the table may be stale. Only reads at the
+    // latest ledger use the table. The ledger is read from the database once
+    // per latest ledger
+    std::optional<std::uint32_t>
+    latestObjectsSince(
+        std::uint32_t const sequence,
+        boost::asio::yield_context& yield) const;
+
+    // Issues numRequests reads concurrently, and suspends the calling
+    // coroutine until all have completed. makeStatement(i) builds the i-th
+    // statement and onSuccess(result, out) parses a row into the i-th result.
+    // Requests that return no rows leave their result default constructed.
+    // Throws DatabaseTimeout if any request failed
+    template <class T, class MakeStatement, class OnSuccess>
+    std::vector<T>
+    executeBatchRead(
+        std::size_t const numRequests,
+        MakeStatement&& makeStatement,
+        OnSuccess&& onSuccess,
+        boost::asio::yield_context& yield) const;
+
+    std::vector<Blob>
+    fetchObjectsFromHistory(
+        std::vector<ripple::uint256> const& keys,
+        std::uint32_t const sequence,
+        boost::asio::yield_context& yield) const;
+
+    // Online delete splits the state at minLedger into ranges of keys
+    // (start, end], which are processed in parallel. Progress of each range is
+    // checkpointed to the database, so an interrupted online delete resumes
+    // where it left off
+    struct OnlineDeleteRange
+    {
+        std::size_t index;
+        std::uint32_t minLedger;
+        ripple::uint256 start;
+        ripple::uint256 end;
+        // last key processed
+        ripple::uint256 cursor;
+        bool done = false;
+    };
+
+    // number of threads processing ranges concurrently
+    std::uint32_t onlineDeleteWorkers_ = 4;
+    // number of ranges the state is split into
+    std::uint32_t onlineDeleteRanges_ = 64;
+    // maximum number of in flight writes per worker
+    std::uint32_t onlineDeleteWriteConcurrency_ = 64;
+    // maximum number of object bytes rewritten per second. 0 means unlimited
+    std::uint64_t onlineDeleteBytesPerSecond_ = 0;
+
+    mutable std::mutex onlineDeleteMtx_;
+    mutable OnlineDeleteStatus onlineDeleteStatus_;
+    // earliest time the next page may be written, when rate limited
+    mutable std::chrono::steady_clock::time_point onlineDeleteNextWrite_;
+
+    std::vector<OnlineDeleteRange>
+    fetchOnlineDeleteProgress(
+        LedgerRange const& range,
+        boost::asio::yield_context& yield) const;
+
+    void
+    writeOnlineDeleteProgress(OnlineDeleteRange const& range) const;
+
+    std::vector<OnlineDeleteRange>
+    makeOnlineDeleteRanges(
+        std::uint32_t const minLedger,
+        boost::asio::yield_context& yield) const;
+
+    void
+    onlineDeleteRange(
+        OnlineDeleteRange& range,
+        boost::asio::yield_context& yield) const;
+
+    void
+    throttleOnlineDelete(std::size_t const bytes) const;
 
 public:
     CassandraBackend(
@@ -727,74 +873,75 @@ public:
         boost::asio::yield_context& yield) const override;
 
     bool
-    doFinishWritesSync()
+    doFinishWritesSync(std::uint32_t const ledgerSequence)
     {
         assert(syncInterval_ == 1);
-        // wait for all other writes to finish
-        sync();
+        // wait for the writes of this and all earlier ledgers to finish.
+        // Writes of later ledgers may still be in flight
+        sync(ledgerSequence);
         // write range
         if (!range)
         {
             CassandraStatement statement{updateLedgerRange_};
-            statement.bindNextInt(ledgerSequence_);
+            statement.bindNextInt(ledgerSequence);
             statement.bindNextBoolean(false);
-            statement.bindNextInt(ledgerSequence_);
+            statement.bindNextInt(ledgerSequence);
             executeSyncWrite(statement);
         }
         CassandraStatement statement{updateLedgerRange_};
-        statement.bindNextInt(ledgerSequence_);
+        statement.bindNextInt(ledgerSequence);
         statement.bindNextBoolean(true);
-        statement.bindNextInt(ledgerSequence_ - 1);
-        if (!executeSyncUpdate(statement))
+        statement.bindNextInt(ledgerSequence - 1);
+        if (!executeSyncUpdate(statement, ledgerSequence))
         {
             BOOST_LOG_TRIVIAL(warning)
                 << __func__ << " Update failed for ledger "
-                << std::to_string(ledgerSequence_) << ". Returning";
+                << std::to_string(ledgerSequence) << ". Returning";
             return false;
         }
         BOOST_LOG_TRIVIAL(info) << __func__ << " Committed ledger "
-                                << std::to_string(ledgerSequence_);
+                                << std::to_string(ledgerSequence);
         return true;
     }
 
     bool
-    doFinishWritesAsync()
+    doFinishWritesAsync(std::uint32_t const ledgerSequence)
     {
         assert(syncInterval_ != 1);
         // if db is empty, sync. if sync interval is 1, always sync.
         // if we've never synced, sync. if its been greater than the configured
         // sync interval since we last synced, sync.
         if (!range || lastSync_ == 0 ||
-            ledgerSequence_ - syncInterval_ >= lastSync_)
+            ledgerSequence - syncInterval_ >= lastSync_)
         {
-            // wait for all other writes to finish
-            sync();
+            // wait for the writes of this and all earlier ledgers to finish
+            sync(ledgerSequence);
             // write range
             if (!range)
             {
                 CassandraStatement statement{updateLedgerRange_};
-                statement.bindNextInt(ledgerSequence_);
+                statement.bindNextInt(ledgerSequence);
                 statement.bindNextBoolean(false);
-                statement.bindNextInt(ledgerSequence_);
+                statement.bindNextInt(ledgerSequence);
                 executeSyncWrite(statement);
             }
             CassandraStatement statement{updateLedgerRange_};
-            statement.bindNextInt(ledgerSequence_);
+            statement.bindNextInt(ledgerSequence);
             statement.bindNextBoolean(true);
             if (lastSync_ == 0)
-                statement.bindNextInt(ledgerSequence_ - 1);
+                statement.bindNextInt(ledgerSequence - 1);
             else
                 statement.bindNextInt(lastSync_);
-            if (!executeSyncUpdate(statement))
+            if (!executeSyncUpdate(statement, ledgerSequence))
             {
                 BOOST_LOG_TRIVIAL(warning)
                     << __func__ << " Update failed for ledger "
-                    << std::to_string(ledgerSequence_) << ". Returning";
+                    << std::to_string(ledgerSequence) << ". Returning";
                 return false;
             }
             BOOST_LOG_TRIVIAL(info) << __func__ << " Committed ledger "
-                                    << std::to_string(ledgerSequence_);
-            lastSync_ = ledgerSequence_;
+                                    << std::to_string(ledgerSequence);
+            lastSync_ = ledgerSequence;
         }
         else
         {
@@ -802,18 +949,44 @@ public:
                 << __func__ << " Skipping commit. sync interval is "
                 << std::to_string(syncInterval_) << " - last sync is "
                 << std::to_string(lastSync_) << " - ledger sequence is "
-                << std::to_string(ledgerSequence_);
+                << std::to_string(ledgerSequence);
         }
         return true;
     }
 
     bool
-    doFinishWrites() override
+    doAdvanceRange(
+        std::uint32_t const maxSequence,
+        std::uint32_t const prevMaxSequence) override
+    {
+        // the caller waited for the writes of every ledger up to maxSequence
+        CassandraStatement statement{updateLedgerRange_};
+        statement.bindNextInt(maxSequence);
+        statement.bindNextBoolean(true);
+        statement.bindNextInt(prevMaxSequence);
+        if (!executeSyncUpdate(statement, maxSequence))
+        {
+            BOOST_LOG_TRIVIAL(warning)
+                << __func__ << " Update failed for ledgers "
+                << std::to_string(prevMaxSequence + 1) << " - "
+                << std::to_string(maxSequence) << ". Returning";
+            return false;
+        }
+        BOOST_LOG_TRIVIAL(info)
+            << __func__ << " Committed ledgers "
+            << std::to_string(prevMaxSequence + 1) << " - "
+            << std::to_string(maxSequence);
+        lastSync_ = maxSequence;
+        return true;
+    }
+
+    bool
+    doFinishWrites(std::uint32_t const ledgerSequence) override
     {
         if (syncInterval_ == 1)
-            return doFinishWritesSync();
+            return doFinishWritesSync(ledgerSequence);
         else
-            return doFinishWritesAsync();
+            return doFinishWritesAsync(ledgerSequence);
     }
     void
     writeLedger(ripple::LedgerInfo const& ledgerInfo, std::string&& header)
@@ -946,8 +1119,8 @@ public:
             return {};
         }
         return {
-            {result.getBytes(),
-             result.getBytes(),
+            {result.getBlob(),
+             result.getBlob(),
              result.getUInt32(),
              result.getUInt32()}};
     }
@@ -1017,16 +1190,55 @@ public:
         syncCv_.wait(lck, [this]() { return finishedAllRequests(); });
     }
 
+    // wait for the writes of ledgerSequence and all earlier ledgers
+    void
+    sync(std::uint32_t const ledgerSequence) const
+    {
+        std::unique_lock<std::mutex> lck(syncMutex_);
+
+        syncCv_.wait(lck, [this, ledgerSequence]() {
+            return writesOutstandingByLedger_.empty() ||
+                writesOutstandingByLedger_.begin()->first > ledgerSequence;
+        });
+    }
+
     bool
     doOnlineDelete(
         std::uint32_t const numLedgersToKeep,
         boost::asio::yield_context& yield) const override;
 
+    OnlineDeleteStatus
+    getOnlineDeleteStatus() const override
+    {
+        std::lock_guard lck(onlineDeleteMtx_);
+        return onlineDeleteStatus_;
+    }
+
+    void
+    syncLedgers(
+        std::uint32_t const minSequence,
+        std::uint32_t const maxSequence) const override
+    {
+        std::unique_lock<std::mutex> lck(syncMutex_);
+
+        syncCv_.wait(lck, [this, minSequence, maxSequence]() {
+            auto it = writesOutstandingByLedger_.lower_bound(minSequence);
+            return it == writesOutstandingByLedger_.end() ||
+                it->first > maxSequence;
+        });
+    }
+
+    void
+    writeBackfillProgress(LedgerRange const& range) const override;
+
+    std::vector<LedgerRange>
+    fetchBackfillProgress(boost::asio::yield_context& yield) const override;
+
     bool
     isTooBusy() const override;
 
     inline void
-    incrementOutstandingRequestCount() const
+    incrementOutstandingRequestCount(std::uint32_t const ledgerSequence) const
     {
         {
             std::unique_lock<std::mutex> lck(throttleMutex_);
@@ -1040,10 +1252,14 @@ public:
             }
         }
         ++numWriteRequestsOutstanding_;
+        {
+            std::lock_guard lck(syncMutex_);
+            ++writesOutstandingByLedger_[ledgerSequence];
+        }
     }
 
     inline void
-    decrementOutstandingRequestCount() const
+    decrementOutstandingRequestCount(std::uint32_t const ledgerSequence) const
     {
         // sanity check
         if (numWriteRequestsOutstanding_ == 0)
@@ -1058,12 +1274,20 @@ public:
             std::lock_guard lck(throttleMutex_);
             throttleCv_.notify_one();
         }
-        if (cur == 0)
         {
             // mutex lock required to prevent race condition around spurious
             // wakeup
             std::lock_guard lck(syncMutex_);
-            syncCv_.notify_one();
+            auto it = writesOutstandingByLedger_.find(ledgerSequence);
+            assert(it != writesOutstandingByLedger_.end());
+            // a ledger's last write finishing may make it committable
+            if (--it->second == 0)
+            {
+                writesOutstandingByLedger_.erase(it);
+                syncCv_.notify_all();
+            }
+            else if (cur == 0)
+                syncCv_.notify_all();
         }
     }
 
@@ -1080,9 +1304,9 @@ public:
     }
 
     void
-    finishAsyncWrite() const
+    finishAsyncWrite(std::uint32_t const ledgerSequence) const
     {
-        decrementOutstandingRequestCount();
+        decrementOutstandingRequestCount(ledgerSequence);
     }
 
     template <class T, class S>
@@ -1108,8 +1332,10 @@ public:
         S& callbackData,
         bool isRetry) const
     {
-        if (!isRetry)
-            incrementOutstandingRequestCount();
+        // bulk writes are throttled by their caller, and not waited for by
+        // sync, so they are not counted here
+        if (!isRetry && callbackData.ledgerSequence)
+            incrementOutstandingRequestCount(*callbackData.ledgerSequence);
         executeAsyncHelper(statement, callback, callbackData);
     }
 
@@ -1146,7 +1372,9 @@ public:
     }
 
     bool
-    executeSyncUpdate(CassandraStatement const& statement) const
+    executeSyncUpdate(
+        CassandraStatement const& statement,
+        std::uint32_t const ledgerSequence) const
     {
         bool timedOut = false;
         CassFuture* fut;
@@ -1199,7 +1427,7 @@ public:
             // happened. So, we just return true as long as what we tried to
             // write was what ended up being written.
             auto rng = hardFetchLedgerRangeNoThrow();
-            return rng && rng->maxSequence == ledgerSequence_;
+            return rng && rng->maxSequence == ledgerSequence;
         }
         return success == cass_true;
     }
@@ -4,6 +4,7 @@
 #include <ripple/basics/Log.h>
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/ledger/ReadView.h>
+#include <ripple/protocol/Indexes.h>
 #include <ripple/protocol/SField.h>
 #include <ripple/protocol/STAccount.h>
 #include <ripple/protocol/TxMeta.h>
@@ -174,6 +175,30 @@ deserializeHeader(ripple::Slice data)
     return info;
 }
 
+/// Read the fee settings from the FeeSettings ledger object
+template <class T>
+inline ripple::Fees
+deserializeFees(T const& object)
+{
+    ripple::Fees fees;
+    ripple::SerialIter it(object.data(), object.size());
+    ripple::SLE sle{it, ripple::keylet::fees().key};
+
+    if (sle.getFieldIndex(ripple::sfBaseFee) != -1)
+        fees.base = sle.getFieldU64(ripple::sfBaseFee);
+
+    if (sle.getFieldIndex(ripple::sfReferenceFeeUnits) != -1)
+        fees.units = sle.getFieldU32(ripple::sfReferenceFeeUnits);
+
+    if (sle.getFieldIndex(ripple::sfReserveBase) != -1)
+        fees.reserve = sle.getFieldU32(ripple::sfReserveBase);
+
+    if (sle.getFieldIndex(ripple::sfReserveIncrement) != -1)
+        fees.increment = sle.getFieldU32(ripple::sfReserveIncrement);
+
+    return fees;
+}
+
 inline std::string
 uint256ToString(ripple::uint256 const& uint)
 {
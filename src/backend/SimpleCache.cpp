@@ -52,7 +52,7 @@ SimpleCache::getSuccessor(ripple::uint256 const& key, uint32_t seq) const
 {
     if (!full_)
         return {};
-    std::shared_lock{mtx_};
+    std::shared_lock lck{mtx_};
     successorReqCounter_++;
     if (seq != latestSeq_)
         return {};
@@ -77,6 +77,52 @@ SimpleCache::getPredecessor(ripple::uint256 const& key, uint32_t seq) const
     --e;
     return {{e->first, e->second.blob}};
 }
+std::vector<
+    std::pair<std::optional<ripple::uint256>, std::optional<ripple::uint256>>>
+SimpleCache::getNeighbors(
+    std::vector<ripple::uint256> const& keys,
+    uint32_t seq) const
+{
+    // number of entries to step through before searching the map from the
+    // root instead
+    constexpr std::size_t maxSteps = 16;
+
+    std::vector<std::pair<
+        std::optional<ripple::uint256>,
+        std::optional<ripple::uint256>>>
+        result;
+    if (!full_)
+        return result;
+    std::shared_lock lck{mtx_};
+    if (seq != latestSeq_)
+        return result;
+    result.reserve(keys.size());
+    // it is the first entry not less than the current key
+    auto it = map_.begin();
+    for (auto const& key : keys)
+    {
+        assert(result.empty() || !(key < keys[result.size() - 1]));
+        std::size_t steps = 0;
+        while (it != map_.end() && it->first < key && steps < maxSteps)
+        {
+            ++it;
+            ++steps;
+        }
+        if (it != map_.end() && it->first < key)
+            it = map_.lower_bound(key);
+
+        auto& [pred, succ] = result.emplace_back();
+        if (it != map_.begin())
+            pred = std::prev(it)->first;
+        auto next = it;
+        if (next != map_.end() && next->first == key)
+            ++next;
+        if (next != map_.end())
+            succ = next->first;
+    }
+    return result;
+}
+
 std::optional<Blob>
 SimpleCache::get(ripple::uint256 const& key, uint32_t seq) const
 {
@@ -54,6 +54,15 @@ public:
     std::optional<LedgerObject>
     getPredecessor(ripple::uint256 const& key, uint32_t seq) const;
 
+    // For each of keys, which must be sorted, the closest keys before and
+    // after it at seq. Keys that are close together share a single walk of the
+    // cache, and the lock is taken once. Returns an empty vector if isFull() is
+    // false or seq is not the latest sequence
+    std::vector<std::pair<
+        std::optional<ripple::uint256>,
+        std::optional<ripple::uint256>>>
+    getNeighbors(std::vector<ripple::uint256> const& keys, uint32_t seq) const;
+
     void
     setDisabled();
 
@@ -1,7 +1,12 @@
 #ifndef CLIO_TYPES_H_INCLUDED
 #define CLIO_TYPES_H_INCLUDED
 #include <ripple/basics/base_uint.h>
+#include <ripple/basics/Slice.h>
 #include <ripple/protocol/AccountID.h>
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -10,7 +15,129 @@ namespace Backend {
 
 // *** return types
 
-using Blob = std::vector<unsigned char>;
+// Immutable, reference counted byte buffer. Objects and transactions are
+// copied out of the database driver once, and every later copy of the Blob
+// (into the cache, into a LedgerObject page, into a handler) only bumps a
+// reference count and shares the same storage.
+class Blob
+{
+    using storage_type = std::vector<unsigned char>;
+
+    std::shared_ptr<storage_type const> data_;
+
+public:
+    using value_type = unsigned char;
+    using size_type = std::size_t;
+    using const_iterator = storage_type::const_iterator;
+    using iterator = const_iterator;
+    using const_reverse_iterator = storage_type::const_reverse_iterator;
+
+    Blob() = default;
+
+    Blob(storage_type&& bytes)
+        : data_(
+              bytes.empty()
+                  ? nullptr
+                  : std::make_shared<storage_type const>(std::move(bytes)))
+    {
+    }
+
+    Blob(storage_type const& bytes) : Blob(storage_type{bytes})
+    {
+    }
+
+    Blob(std::initializer_list<unsigned char> bytes)
+        : Blob(storage_type{bytes})
+    {
+    }
+
+    template <class InputIt>
+    Blob(InputIt first, InputIt last) : Blob(storage_type(first, last))
+    {
+    }
+
+    unsigned char const*
+    data() const
+    {
+        return data_ ? data_->data() : nullptr;
+    }
+
+    std::size_t
+    size() const
+    {
+        return data_ ? data_->size() : 0;
+    }
+
+    bool
+    empty() const
+    {
+        return size() == 0;
+    }
+
+    const_iterator
+    begin() const
+    {
+        return data_ ? data_->begin() : empty_().begin();
+    }
+
+    const_iterator
+    end() const
+    {
+        return data_ ? data_->end() : empty_().end();
+    }
+
+    const_reverse_iterator
+    rbegin() const
+    {
+        return data_ ? data_->rbegin() : empty_().rbegin();
+    }
+
+    const_reverse_iterator
+    rend() const
+    {
+        return data_ ? data_->rend() : empty_().rend();
+    }
+
+    unsigned char
+    operator[](std::size_t i) const
+    {
+        return (*data_)[i];
+    }
+
+    ripple::Slice
+    slice() const
+    {
+        return {data(), size()};
+    }
+
+    /// Number of Blobs sharing this buffer. Mostly useful for testing
+    long
+    useCount() const
+    {
+        return data_.use_count();
+    }
+
+    bool
+    operator==(Blob const& other) const
+    {
+        return data_ == other.data_ ||
+            std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    bool
+    operator!=(Blob const& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    static storage_type const&
+    empty_()
+    {
+        static storage_type const empty;
+        return empty;
+    }
+};
 
 struct LedgerObject
 {
@@ -82,6 +209,21 @@ struct LedgerRange
     std::uint32_t minSequence;
     std::uint32_t maxSequence;
 };
+
+// Progress of the most recent online delete
+struct OnlineDeleteStatus
+{
+    bool running = false;
+    // versions only needed by ledgers older than this are being deleted
+    std::uint32_t minLedger = 0;
+    std::size_t numRanges = 0;
+    std::size_t rangesDone = 0;
+    std::uint64_t objectsWritten = 0;
+    std::uint64_t bytesWritten = 0;
+    std::chrono::system_clock::time_point startTime;
+    std::chrono::system_clock::time_point endTime;
+};
+
 constexpr ripple::uint256 firstKey{
     "0000000000000000000000000000000000000000000000000000000000000000"};
 constexpr ripple::uint256 lastKey{
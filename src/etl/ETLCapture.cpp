@@ -0,0 +1,161 @@
+#include <etl/ETLCapture.h>
+
+#include <stdexcept>
+
+namespace {
+
+template <class T>
+void
+putLittleEndian(char*& out, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        *out++ = static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+template <class T>
+T
+getLittleEndian(char const*& in)
+{
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<T>(static_cast<unsigned char>(*in++)) << (8 * i);
+    return value;
+}
+
+}  // namespace
+
+ETLCapture::ETLCapture(std::string const& path)
+    : out_(path, std::ios::binary | std::ios::trunc)
+    , start_(std::chrono::steady_clock::now())
+{
+    if (!out_)
+        throw std::runtime_error("Failed to open capture file " + path);
+}
+
+void
+ETLCapture::write(
+    RecordType type,
+    std::uint32_t sequence,
+    std::string const& data)
+{
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start_)
+                      .count();
+
+    char header[headerSize];
+    char* out = header;
+    putLittleEndian(out, static_cast<std::uint8_t>(type));
+    putLittleEndian(out, sequence);
+    putLittleEndian(out, static_cast<std::uint64_t>(micros));
+    putLittleEndian(out, static_cast<std::uint32_t>(data.size()));
+
+    std::lock_guard lck{mtx_};
+    out_.write(header, headerSize);
+    out_.write(data.data(), data.size());
+    out_.flush();
+}
+
+void
+ETLCapture::write(
+    RecordType type,
+    std::uint32_t sequence,
+    google::protobuf::MessageLite const& message)
+{
+    write(type, sequence, message.SerializeAsString());
+}
+
+void
+ETLCapture::finishLedgerData(std::uint32_t sequence)
+{
+    write(RecordType::LEDGER_DATA_DONE, sequence, std::string{});
+}
+
+ETLCaptureReader::ETLCaptureReader(std::string const& path)
+    : path_(path), in_(path, std::ios::binary)
+{
+    if (!in_)
+        throw std::runtime_error("Failed to open capture file " + path);
+
+    char bytes[ETLCapture::headerSize];
+    while (in_.read(bytes, ETLCapture::headerSize))
+    {
+        char const* in = bytes;
+        ETLCapture::RecordHeader header;
+        header.type = static_cast<ETLCapture::RecordType>(
+            getLittleEndian<std::uint8_t>(in));
+        header.sequence = getLittleEndian<std::uint32_t>(in);
+        header.micros = getLittleEndian<std::uint64_t>(in);
+        header.size = getLittleEndian<std::uint32_t>(in);
+
+        Record record{
+            static_cast<std::uint64_t>(in_.tellg()),
+            header.size,
+            header.micros};
+        if (header.type == ETLCapture::RecordType::LEDGER)
+            ledgers_[header.sequence] = record;
+        else if (header.type == ETLCapture::RecordType::LEDGER_DATA)
+            ledgerData_[header.sequence].push_back(record);
+        else if (header.type == ETLCapture::RecordType::LEDGER_DATA_DONE)
+            completeLedgerData_.insert(header.sequence);
+        else
+            throw std::runtime_error("Unknown record in capture file " + path);
+        in_.seekg(header.size, std::ios::cur);
+    }
+    in_.clear();
+}
+
+std::string
+ETLCaptureReader::read(Record const& record) const
+{
+    std::string data(record.size, '\0');
+    std::lock_guard lck{mtx_};
+    in_.seekg(record.offset);
+    if (!in_.read(data.data(), data.size()))
+    {
+        in_.clear();
+        throw std::runtime_error("Truncated capture file " + path_);
+    }
+    return data;
+}
+
+std::vector<std::pair<std::uint32_t, std::uint64_t>>
+ETLCaptureReader::getLedgers() const
+{
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> ledgers;
+    for (auto const& [sequence, record] : ledgers_)
+        ledgers.emplace_back(sequence, record.micros);
+    return ledgers;
+}
+
+std::optional<std::string>
+ETLCaptureReader::getLedger(std::uint32_t sequence) const
+{
+    auto it = ledgers_.find(sequence);
+    if (it == ledgers_.end())
+        return {};
+    return read(it->second);
+}
+
+std::vector<std::string>
+ETLCaptureReader::getLedgerData(std::uint32_t sequence) const
+{
+    std::vector<std::string> pages;
+    auto it = ledgerData_.find(sequence);
+    if (it == ledgerData_.end())
+        return pages;
+    for (auto const& record : it->second)
+        pages.push_back(read(record));
+    return pages;
+}
+
+std::optional<std::uint32_t>
+ETLCaptureReader::getFirstSequence() const
+{
+    std::optional<std::uint32_t> first;
+    if (!ledgers_.empty())
+        first = ledgers_.begin()->first;
+    if (!completeLedgerData_.empty() &&
+        (!first || *completeLedgerData_.begin() < *first))
+        first = *completeLedgerData_.begin();
+    return first;
+}
@@ -0,0 +1,127 @@
+#ifndef CLIO_ETLCAPTURE_H_INCLUDED
+#define CLIO_ETLCAPTURE_H_INCLUDED
+
+#include <google/protobuf/message_lite.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+/// Records the responses received from the ETL sources to a file, so that the
+/// ETL can be run again later without a rippled node, see ReplayETLSource.
+///
+/// The file is a sequence of records. Each record is a header of
+/// headerSize bytes followed by the serialized message. The header holds the
+/// type (1 byte), the ledger sequence (4 bytes), the microseconds since the
+/// capture started (8 bytes) and the size of the message (4 bytes), each
+/// little endian. An existing file is overwritten
+class ETLCapture
+{
+public:
+    enum class RecordType : std::uint8_t {
+        // GetLedgerResponse of a ledger and its diff
+        LEDGER = 1,
+        // GetLedgerDataResponse, one page of an initial ledger download
+        LEDGER_DATA = 2,
+        // no message. The initial download of the ledger completed, so all
+        // of its pages are in the file
+        LEDGER_DATA_DONE = 3
+    };
+
+    struct RecordHeader
+    {
+        RecordType type;
+        std::uint32_t sequence;
+        std::uint64_t micros;
+        std::uint32_t size;
+    };
+
+    static constexpr std::size_t headerSize = 1 + 4 + 8 + 4;
+
+private:
+    std::mutex mtx_;
+    std::ofstream out_;
+    std::chrono::steady_clock::time_point start_;
+
+    void
+    write(RecordType type, std::uint32_t sequence, std::string const& data);
+
+public:
+    ETLCapture(std::string const& path);
+
+    /// Append a message to the file. Safe to call from several threads
+    void
+    write(
+        RecordType type,
+        std::uint32_t sequence,
+        google::protobuf::MessageLite const& message);
+
+    /// Mark the initial download of a ledger as complete
+    void
+    finishLedgerData(std::uint32_t sequence);
+};
+
+/// Reads a file written by ETLCapture. The file is scanned once on
+/// construction, and the messages are read from the file when requested
+class ETLCaptureReader
+{
+    std::string path_;
+    mutable std::mutex mtx_;
+    mutable std::ifstream in_;
+
+    struct Record
+    {
+        std::uint64_t offset;
+        std::uint32_t size;
+        std::uint64_t micros;
+    };
+    std::map<std::uint32_t, Record> ledgers_;
+    std::map<std::uint32_t, std::vector<Record>> ledgerData_;
+    std::set<std::uint32_t> completeLedgerData_;
+
+    std::string
+    read(Record const& record) const;
+
+public:
+    ETLCaptureReader(std::string const& path);
+
+    std::string const&
+    getPath() const
+    {
+        return path_;
+    }
+
+    /// Sequences of the captured ledgers, in order, with the time each one
+    /// was captured at, in microseconds since the capture started
+    std::vector<std::pair<std::uint32_t, std::uint64_t>>
+    getLedgers() const;
+
+    /// Serialized GetLedgerResponse of a ledger, if it was captured
+    std::optional<std::string>
+    getLedger(std::uint32_t sequence) const;
+
+    /// Whether the whole initial download of a ledger was captured
+    bool
+    hasLedgerData(std::uint32_t sequence) const
+    {
+        return completeLedgerData_.count(sequence);
+    }
+
+    /// Serialized GetLedgerDataResponse of every captured page of the initial
+    /// download of a ledger, in the order they were received
+    std::vector<std::string>
+    getLedgerData(std::uint32_t sequence) const;
+
+    /// The lowest sequence of a captured ledger or of a complete initial
+    /// download, if there is any
+    std::optional<std::uint32_t>
+    getFirstSequence() const;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define RIPPLE_APP_REPORTING_ETLHELPERS_H_INCLUDED
 #include <ripple/basics/base_uint.h>
 #include <condition_variable>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <queue>
@@ -152,23 +153,65 @@ public:
     }
 };
 
+/// The first 8 bytes of key, as an integer. Positions in the keyspace are
+/// compared and divided using this prefix
+inline std::uint64_t
+getKeyPrefix(ripple::uint256 const& key)
+{
+    std::uint64_t prefix = 0;
+    for (std::size_t i = 0; i < sizeof(prefix); ++i)
+        prefix = (prefix << 8) | key.data()[i];
+    return prefix;
+}
+
+/// The smallest key that starts with prefix
+inline ripple::uint256
+getKeyFromPrefix(std::uint64_t prefix)
+{
+    ripple::uint256 key{0};
+    for (std::size_t i = sizeof(prefix); i > 0; --i)
+    {
+        key.data()[i - 1] = prefix & 0xff;
+        prefix >>= 8;
+    }
+    return key;
+}
+
+/// A key roughly halfway between from and to. An empty to means the end of
+/// the keyspace. Returns an empty optional if the range is too small to split
+inline std::optional<ripple::uint256>
+getMidpoint(
+    ripple::uint256 const& from,
+    std::optional<ripple::uint256> const& to)
+{
+    std::uint64_t lo = getKeyPrefix(from);
+    std::uint64_t hi =
+        to ? getKeyPrefix(*to) : std::numeric_limits<std::uint64_t>::max();
+    if (hi <= lo)
+        return {};
+    std::uint64_t mid = lo + (hi - lo) / 2;
+    if (mid <= lo)
+        return {};
+    return getKeyFromPrefix(mid);
+}
+
 /// Parititions the uint256 keyspace into numMarkers partitions, each of equal
 /// size.
 inline std::vector<ripple::uint256>
 getMarkers(size_t numMarkers)
 {
-    assert(numMarkers <= 256);
+    assert(numMarkers > 0);
 
-    unsigned char incr = 256 / numMarkers;
+    // the keyspace is divided by the first 8 bytes of the key. Rounding up
+    // keeps the last marker inside the keyspace and, for powers of 2, gives
+    // exactly equal partitions
+    std::uint64_t incr =
+        std::numeric_limits<std::uint64_t>::max() / numMarkers + 1;
 
     std::vector<ripple::uint256> markers;
     markers.reserve(numMarkers);
-    ripple::uint256 base{0};
     for (size_t i = 0; i < numMarkers; ++i)
-    {
-        markers.push_back(base);
-        base.data()[0] += incr;
-    }
+        markers.push_back(getKeyFromPrefix(i * incr));
     return markers;
 }
 
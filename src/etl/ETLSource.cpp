@@ -9,8 +9,11 @@
 #include <backend/DBHelpers.h>
 #include <etl/ETLSource.h>
 #include <etl/ProbingETLSource.h>
+#include <etl/ReplayETLSource.h>
 #include <etl/ReportingETL.h>
 #include <rpc/RPCHelpers.h>
+#include <algorithm>
+#include <deque>
 #include <thread>
 
 void
@@ -554,6 +557,54 @@ ETLSourceImpl<Derived>::handleMessage()
     }
 }
 
+InitialLedgerRangeWriter::InitialLedgerRangeWriter(
+    BackendInterface& backend,
+    std::uint32_t sequence,
+    ripple::uint256 const& start)
+    : backend_(backend), sequence_(sequence), start_(start)
+{
+    if (start.isZero())
+        lastKey_ = uint256ToString(Backend::firstKey);
+}
+
+void
+InitialLedgerRangeWriter::write(
+    ripple::uint256 const& key,
+    std::string&& keyBytes,
+    std::string&& blob)
+{
+    if (isBookDir(key, blob))
+        writeBookBase(key);
+    if (lastKey_.size())
+        backend_.writeSuccessor(
+            std::move(lastKey_), sequence_, std::string{keyBytes});
+    lastKey_ = keyBytes;
+    backend_.writeLedgerObject(std::move(keyBytes), sequence_, std::move(blob));
+}
+
+void
+InitialLedgerRangeWriter::writeBookBase(ripple::uint256 const& key)
+{
+    auto base = getBookBase(key);
+    if (base == key)
+        return;
+    if (lastKey_.empty())
+    {
+        if (base < start_)
+        {
+            edgeBookDir_ = key;
+            return;
+        }
+    }
+    else if (ripple::uint256::fromVoid(lastKey_.data()) >= base)
+        return;
+    BOOST_LOG_TRIVIAL(debug)
+        << __func__ << " Writing book successor = " << ripple::strHex(base)
+        << " - " << ripple::strHex(key);
+    backend_.writeSuccessor(
+        uint256ToString(base), sequence_, uint256ToString(key));
+}
+
 class AsyncCallData
 {
     std::unique_ptr<org::xrpl::rpc::v1::GetLedgerDataResponse> cur_;
@@ -563,15 +614,23 @@ class AsyncCallData
     std::unique_ptr<grpc::ClientContext> context_;
 
     grpc::Status status_;
-    unsigned char nextPrefix_;
+    // end of the range downloaded by this call (exclusive). Empty means the
+    // end of the keyspace. May shrink when the range is split
+    std::optional<ripple::uint256> nextMarker_;
+    bool done_ = false;
 
-    std::string lastKey_;
+    InitialLedgerRangeWriter writer_;
+    // records every page received, if not null
+    ETLCapture* capture_;
 
 public:
     AsyncCallData(
         uint32_t seq,
         ripple::uint256 const& marker,
-        std::optional<ripple::uint256> const& nextMarker)
+        std::optional<ripple::uint256> const& nextMarker,
+        BackendInterface& backend,
+        ETLCapture* capture)
+        : writer_(backend, seq, marker), capture_(capture)
     {
         request_.mutable_ledger()->set_sequence(seq);
         if (marker.isNonZero())
@@ -579,19 +638,14 @@ public:
             request_.set_marker(marker.data(), marker.size());
         }
         request_.set_user("ETL");
-        nextPrefix_ = 0x00;
-        if (nextMarker)
-            nextPrefix_ = nextMarker->data()[0];
-
-        unsigned char prefix = marker.data()[0];
+        nextMarker_ = nextMarker;
 
         BOOST_LOG_TRIVIAL(debug)
             << "Setting up AsyncCallData. marker = " << ripple::strHex(marker)
-            << " . prefix = " << ripple::strHex(std::string(1, prefix))
-            << " . nextPrefix_ = "
-            << ripple::strHex(std::string(1, nextPrefix_));
+            << " . nextMarker_ = "
+            << (nextMarker_ ? ripple::strHex(*nextMarker_) : "none");
 
-        assert(nextPrefix_ > prefix || nextPrefix_ == 0x00);
+        assert(!nextMarker_ || *nextMarker_ > marker);
 
         cur_ = std::make_unique<org::xrpl::rpc::v1::GetLedgerDataResponse>();
 
@@ -608,6 +662,72 @@ public:
         BackendInterface& backend,
         bool abort,
         bool cacheOnly = false)
+    {
+        auto status = doProcess(stub, cq, backend, abort, cacheOnly);
+        if (status != CallStatus::MORE)
+            done_ = true;
+        return status;
+    }
+
+    /// Whether the last response of this call has been processed
+    bool
+    isDone() const
+    {
+        return done_;
+    }
+
+    /// Start of the part of the range that has not been received yet
+    ripple::uint256
+    getMarker() const
+    {
+        if (auto marker = ripple::uint256::fromVoidChecked(request_.marker()))
+            return *marker;
+        return ripple::uint256{0};
+    }
+
+    /// Size of the part of the range that has not been received yet
+    std::uint64_t
+    getRemaining() const
+    {
+        std::uint64_t hi = nextMarker_
+            ? getKeyPrefix(*nextMarker_)
+            : std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t lo = getKeyPrefix(getMarker());
+        return hi > lo ? hi - lo : 0;
+    }
+
+    /// The part of the range that has not been received yet
+    InitialLedgerRanges::Range
+    getRemainingRange() const
+    {
+        return {getMarker(), nextMarker_};
+    }
+
+    /// Stop this call halfway through the part of its range that has not been
+    /// received yet, and return the upper half, which the caller must
+    /// download. Returns an empty optional if the rest of the range is too
+    /// small to split
+    std::optional<InitialLedgerRanges::Range>
+    split()
+    {
+        if (done_)
+            return {};
+        auto mid = getMidpoint(getMarker(), nextMarker_);
+        if (!mid)
+            return {};
+        auto end = nextMarker_;
+        nextMarker_ = *mid;
+        return {{*mid, end}};
+    }
+
+private:
+    CallStatus
+    doProcess(
+        std::unique_ptr<org::xrpl::rpc::v1::XRPLedgerAPIService::Stub>& stub,
+        grpc::CompletionQueue& cq,
+        BackendInterface& backend,
+        bool abort,
+        bool cacheOnly)
     {
         BOOST_LOG_TRIVIAL(trace) << "Processing response. "
                                  << "Marker prefix = " << getMarkerPrefix();
@@ -633,6 +753,12 @@ public:
 
         std::swap(cur_, next_);
 
+        if (capture_)
+            capture_->write(
+                ETLCapture::RecordType::LEDGER_DATA,
+                request_.ledger().sequence(),
+                *cur_);
+
         bool more = true;
 
         // if no marker returned, we are done
@@ -640,8 +766,8 @@ public:
             more = false;
 
         // if returned marker is greater than our end, we are done
-        unsigned char prefix = cur_->marker()[0];
-        if (nextPrefix_ != 0x00 && prefix >= nextPrefix_)
+        auto marker = ripple::uint256::fromVoidChecked(cur_->marker());
+        if (nextMarker_ && marker && *marker >= *nextMarker_)
             more = false;
 
         // if we are not done, make the next async call
@@ -657,27 +783,19 @@ public:
         for (int i = 0; i < cur_->ledger_objects().objects_size(); ++i)
         {
             auto& obj = *(cur_->mutable_ledger_objects()->mutable_objects(i));
-            if (!more && nextPrefix_ != 0x00)
-            {
-                if (((unsigned char)obj.key()[0]) >= nextPrefix_)
-                    continue;
-            }
+            auto key = ripple::uint256::fromVoidChecked(obj.key());
+            assert(key);
+            // belongs to the next range
+            if (!more && nextMarker_ && *key >= *nextMarker_)
+                continue;
             cacheUpdates.push_back(
-                {*ripple::uint256::fromVoidChecked(obj.key()),
+                {*key,
                  {obj.mutable_data()->begin(), obj.mutable_data()->end()}});
             if (!cacheOnly)
-            {
-                if (lastKey_.size())
-                    backend.writeSuccessor(
-                        std::move(lastKey_),
-                        request_.ledger().sequence(),
-                        std::string{obj.key()});
-                lastKey_ = obj.key();
-                backend.writeLedgerObject(
+                writer_.write(
+                    *key,
                     std::move(*obj.mutable_key()),
-                    request_.ledger().sequence(),
                     std::move(*obj.mutable_data()));
-            }
         }
         backend.cache().update(
             cacheUpdates, request_.ledger().sequence(), cacheOnly);
@@ -686,6 +804,7 @@ public:
         return more ? CallStatus::MORE : CallStatus::DONE;
     }
 
+public:
     void
     call(
         std::unique_ptr<org::xrpl::rpc::v1::XRPLedgerAPIService::Stub>& stub,
@@ -714,7 +833,13 @@ public:
     std::string
     getLastKey()
     {
-        return lastKey_;
+        return writer_.getLastKey();
+    }
+
+    std::optional<ripple::uint256>
+    getEdgeBookDir() const
+    {
+        return writer_.getEdgeBookDir();
     }
 };
 
@@ -722,6 +847,7 @@ template <class Derived>
 bool
 ETLSourceImpl<Derived>::loadInitialLedger(
     uint32_t sequence,
+    InitialLedgerRanges& ranges,
     uint32_t numMarkers,
     bool cacheOnly)
 {
@@ -734,148 +860,136 @@ ETLSourceImpl<Derived>::loadInitialLedger(
 
     bool ok = false;
 
-    std::vector<AsyncCallData> calls;
-    auto markers = getMarkers(numMarkers);
-
-    for (size_t i = 0; i < markers.size(); ++i)
-    {
-        std::optional<ripple::uint256> nextMarker;
-        if (i + 1 < markers.size())
-            nextMarker = markers[i + 1];
-        calls.emplace_back(sequence, markers[i], nextMarker);
-    }
+    ETLCapture* capture = balancer_.getCapture();
+
+    // calls are referenced by the completion queue, so they must not move
+    std::vector<std::unique_ptr<AsyncCallData>> calls;
+    size_t numSplits = 0;
+    auto startCall = [&](InitialLedgerRanges::Range const& range) {
+        calls.push_back(std::make_unique<AsyncCallData>(
+            sequence, range.first, range.second, *backend_, capture));
+        calls.back()->call(stub_, cq);
+    };
+    // Take the next range shared with the other sources. Once all are taken,
+    // take over the upper half of the largest range still being downloaded
+    // by this source. This keeps all of the calls busy until the end, no
+    // matter how unevenly the objects are spread over the keyspace
+    auto startNext = [&]() {
+        auto range = ranges.pop();
+        if (!range)
+        {
+            AsyncCallData* largest = nullptr;
+            for (auto& c : calls)
+            {
+                if (!c->isDone() &&
+                    (!largest || c->getRemaining() > largest->getRemaining()))
+                    largest = c.get();
+            }
+            if (!largest)
+                return false;
+            range = largest->split();
+            if (!range)
+                return false;
+            BOOST_LOG_TRIVIAL(debug)
+                << "Splitting range at " << ripple::strHex(range->first);
+            ++numSplits;
+        }
+        startCall(*range);
+        return true;
+    };
 
     BOOST_LOG_TRIVIAL(debug) << "Starting data download for ledger " << sequence
                              << ". Using source = " << toString();
 
-    for (auto& c : calls)
-        c.call(stub_, cq);
+    ranges.addSource();
+    size_t numActive = 0;
+    while (numActive < numMarkers && startNext())
+        ++numActive;
 
     size_t numFinished = 0;
+    size_t numReturned = 0;
     bool abort = false;
     size_t incr = 500000;
     size_t progress = incr;
-    std::vector<std::string> edgeKeys;
-    while (numFinished < calls.size() && cq.Next(&tag, &ok))
+    while (true)
     {
+        if (numActive == 0)
+        {
+            if (abort)
+                break;
+            // all of this source's ranges are done. Wait for another source
+            // to fail and give its ranges back, or for all to finish
+            auto range = ranges.waitForRange();
+            if (!range)
+                break;
+            startCall(*range);
+            ++numActive;
+            while (numActive < numMarkers && startNext())
+                ++numActive;
+        }
+        if (!cq.Next(&tag, &ok))
+        {
+            BOOST_LOG_TRIVIAL(error) << "loadInitialLedger - queue shut down";
+            abort = true;
+            break;
+        }
         assert(tag);
 
         auto ptr = static_cast<AsyncCallData*>(tag);
 
+        AsyncCallData::CallStatus result = AsyncCallData::CallStatus::ERRORED;
         if (!ok)
         {
             BOOST_LOG_TRIVIAL(error) << "loadInitialLedger - ok is false";
-            return false;
-            // handle cancelled
+            abort = true;
         }
         else
         {
             BOOST_LOG_TRIVIAL(trace)
                 << "Marker prefix = " << ptr->getMarkerPrefix();
-            auto result = ptr->process(stub_, cq, *backend_, abort, cacheOnly);
-            if (result != AsyncCallData::CallStatus::MORE)
-            {
-                numFinished++;
-                BOOST_LOG_TRIVIAL(debug)
-                    << "Finished a marker. "
-                    << "Current number of finished = " << numFinished;
-                std::string lastKey = ptr->getLastKey();
-                if (lastKey.size())
-                    edgeKeys.push_back(ptr->getLastKey());
-            }
-            if (result == AsyncCallData::CallStatus::ERRORED)
-            {
-                abort = true;
-            }
-            if (backend_->cache().size() > progress)
-            {
-                BOOST_LOG_TRIVIAL(info)
-                    << "Downloaded " << backend_->cache().size()
-                    << " records from rippled";
-                progress += incr;
-            }
+            result = ptr->process(stub_, cq, *backend_, abort, cacheOnly);
         }
-    }
-    BOOST_LOG_TRIVIAL(info)
-        << __func__ << " - finished loadInitialLedger. cache size = "
-        << backend_->cache().size();
-    size_t numWrites = 0;
-    if (!abort)
-    {
-        backend_->cache().setFull();
-        if (!cacheOnly)
+        if (result == AsyncCallData::CallStatus::ERRORED)
         {
-            auto start = std::chrono::system_clock::now();
-            for (auto& key : edgeKeys)
-            {
-                BOOST_LOG_TRIVIAL(debug)
-                    << __func__
-                    << " writing edge key = " << ripple::strHex(key);
-                auto succ = backend_->cache().getSuccessor(
-                    *ripple::uint256::fromVoidChecked(key), sequence);
-                if (succ)
-                    backend_->writeSuccessor(
-                        std::move(key), sequence, uint256ToString(succ->key));
-            }
-            ripple::uint256 prev = Backend::firstKey;
-            while (auto cur = backend_->cache().getSuccessor(prev, sequence))
-            {
-                assert(cur);
-                if (prev == Backend::firstKey)
-                {
-                    backend_->writeSuccessor(
-                        uint256ToString(prev),
-                        sequence,
-                        uint256ToString(cur->key));
-                }
-
-                if (isBookDir(cur->key, cur->blob))
-                {
-                    auto base = getBookBase(cur->key);
-                    // make sure the base is not an actual object
-                    if (!backend_->cache().get(cur->key, sequence))
-                    {
-                        auto succ =
-                            backend_->cache().getSuccessor(base, sequence);
-                        assert(succ);
-                        if (succ->key == cur->key)
-                        {
-                            BOOST_LOG_TRIVIAL(debug)
-                                << __func__ << " Writing book successor = "
-                                << ripple::strHex(base) << " - "
-                                << ripple::strHex(cur->key);
-
-                            backend_->writeSuccessor(
-                                uint256ToString(base),
-                                sequence,
-                                uint256ToString(cur->key));
-                        }
-                    }
-                    ++numWrites;
-                }
-                prev = std::move(cur->key);
-                if (numWrites % 100000 == 0 && numWrites != 0)
-                    BOOST_LOG_TRIVIAL(info) << __func__ << " Wrote "
-                                            << numWrites << " book successors";
-            }
-
-            backend_->writeSuccessor(
-                uint256ToString(prev),
-                sequence,
-                uint256ToString(Backend::lastKey));
-
-            ++numWrites;
-            auto end = std::chrono::system_clock::now();
-            auto seconds =
-                std::chrono::duration_cast<std::chrono::seconds>(end - start)
-                    .count();
-            BOOST_LOG_TRIVIAL(info)
-                << __func__
-                << " - Looping through cache and submitting all writes took "
-                << seconds
-                << " seconds. numWrites = " << std::to_string(numWrites);
+            abort = true;
+            // the other sources finish this range, starting at the first key
+            // that was not received
+            ranges.push(ptr->getRemainingRange());
+            ++numReturned;
         }
+        if (result != AsyncCallData::CallStatus::MORE)
+        {
+            numActive--;
+            numFinished++;
+            BOOST_LOG_TRIVIAL(debug)
+                << "Finished a marker. "
+                << "Current number of finished = " << numFinished;
+            std::string lastKey = ptr->getLastKey();
+            if (lastKey.size())
+                ranges.addEdgeKey(std::move(lastKey));
+            if (auto bookDir = ptr->getEdgeBookDir())
+                ranges.addEdgeBookDir(*bookDir);
+            if (!abort && startNext())
+                numActive++;
+        }
+        if (backend_->cache().size() > progress)
+        {
+            BOOST_LOG_TRIVIAL(info) << "Downloaded " << backend_->cache().size()
+                                    << " records from rippled";
+            progress += incr;
+        }
+    }
+    if (abort)
+    {
+        BOOST_LOG_TRIVIAL(error)
+            << __func__ << " - failed to download from source = " << toString()
+            << ". Gave back " << numReturned << " ranges";
+        ranges.removeSource();
     }
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " - downloaded " << numFinished - numReturned
+        << " ranges from source = " << toString() << ". " << numSplits
+        << " ranges were split to keep all calls busy";
     return !abort;
 }
 
@@ -920,13 +1034,18 @@ make_ETLSource(
     std::shared_ptr<NetworkValidatedLedgers> networkValidatedLedgers,
     ETLLoadBalancer& balancer)
 {
-    auto src = std::make_unique<ProbingETLSource>(
-        config,
-        ioContext,
-        backend,
-        subscriptions,
-        networkValidatedLedgers,
-        balancer);
+    std::unique_ptr<ETLSource> src;
+    if (config.contains("replay_file"))
+        src = std::make_unique<ReplayETLSource>(
+            config, backend, networkValidatedLedgers);
+    else
+        src = std::make_unique<ProbingETLSource>(
+            config,
+            ioContext,
+            backend,
+            subscriptions,
+            networkValidatedLedgers,
+            balancer);
 
     src->run();
 
@@ -939,18 +1058,35 @@ ETLLoadBalancer::ETLLoadBalancer(
     std::shared_ptr<BackendInterface> backend,
     std::shared_ptr<SubscriptionManager> subscriptions,
     std::shared_ptr<NetworkValidatedLedgers> nwvl)
+    : backend_(backend)
 {
     if (config.contains("num_markers") && config.at("num_markers").is_int64())
     {
         downloadRanges_ = config.at("num_markers").as_int64();
 
-        downloadRanges_ = std::clamp(downloadRanges_, {1}, {256});
+        downloadRanges_ = std::clamp(downloadRanges_, {1}, {4096});
     }
     else if (backend->fetchLedgerRange())
     {
         downloadRanges_ = 4;
     }
 
+    if (config.contains("etl_capture_file"))
+    {
+        if (!config.at("etl_capture_file").is_string())
+            throw std::runtime_error("etl_capture_file must be a string");
+        capture_ = std::make_unique<ETLCapture>(
+            config.at("etl_capture_file").as_string().c_str());
+    }
+
+    if (config.contains("fetch_hedge_ms"))
+    {
+        if (!config.at("fetch_hedge_ms").is_int64())
+            throw std::runtime_error("fetch_hedge_ms must be a number");
+        hedgeAfter_ = std::chrono::milliseconds{
+            std::max<std::int64_t>(config.at("fetch_hedge_ms").as_int64(), 0)};
+    }
+
     for (auto& entry : config.at("etl_sources").as_array())
     {
         std::unique_ptr<ETLSource> source = make_ETLSource(
@@ -960,24 +1096,102 @@ ETLLoadBalancer::ETLLoadBalancer(
         BOOST_LOG_TRIVIAL(info) << __func__ << " : added etl source - "
                                 << sources_.back()->toString();
     }
+    stats_.resize(sources_.size());
 }
 
 void
 ETLLoadBalancer::loadInitialLedger(uint32_t sequence, bool cacheOnly)
 {
-    execute(
-        [this, &sequence, cacheOnly](auto& source) {
-            bool res =
-                source->loadInitialLedger(sequence, downloadRanges_, cacheOnly);
-            if (!res)
-            {
-                BOOST_LOG_TRIVIAL(error) << "Failed to download initial ledger."
-                                         << " Sequence = " << sequence
-                                         << " source = " << source->toString();
-            }
-            return res;
-        },
-        sequence);
+    // The keyspace is split into more ranges than there are concurrent
+    // calls, and the ranges are shared by all of the sources. A call that
+    // finishes its range starts the next one, on whichever source it runs
+    constexpr std::uint32_t rangesPerCall = 4;
+    InitialLedgerRanges ranges{
+        getMarkers(downloadRanges_ * rangesPerCall * sources_.size())};
+
+    auto start = std::chrono::system_clock::now();
+    while (true)
+    {
+        std::atomic_bool anySucceeded = false;
+        std::vector<std::thread> threads;
+        for (auto& source : sources_)
+        {
+            threads.emplace_back([&, src = source.get()]() {
+                if (src->loadInitialLedger(
+                        sequence, ranges, downloadRanges_, cacheOnly))
+                    anySucceeded = true;
+                else
+                    BOOST_LOG_TRIVIAL(error)
+                        << "Failed to download initial ledger."
+                        << " Sequence = " << sequence
+                        << " source = " << src->toString();
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+
+        // a range can only be left over if a source failed after the others
+        // had finished
+        if (ranges.empty())
+            break;
+        if (!anySucceeded)
+        {
+            BOOST_LOG_TRIVIAL(error)
+                << __func__ << " : "
+                << "Error downloading initial ledger = " << sequence
+                << " - Tried all sources. Sleeping and trying again";
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+        }
+    }
+    auto end = std::chrono::system_clock::now();
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " - finished loadInitialLedger in "
+        << std::chrono::duration_cast<std::chrono::seconds>(end - start)
+               .count()
+        << " seconds. cache size = " << backend_->cache().size();
+
+    if (capture_)
+        capture_->finishLedgerData(sequence);
+
+    backend_->cache().setFull();
+    if (cacheOnly)
+        return;
+
+    // successors within a range were written as the range was downloaded.
+    // Only the last key of each range, and the first book directory of a
+    // range, need the other ranges
+    size_t numWrites = 0;
+    for (auto& key : ranges.getEdgeKeys())
+    {
+        BOOST_LOG_TRIVIAL(debug)
+            << __func__ << " writing edge key = " << ripple::strHex(key);
+        auto succ = backend_->cache().getSuccessor(
+            *ripple::uint256::fromVoidChecked(key), sequence);
+        backend_->writeSuccessor(
+            std::move(key),
+            sequence,
+            uint256ToString(succ ? succ->key : Backend::lastKey));
+        ++numWrites;
+    }
+    for (auto const& bookDir : ranges.getEdgeBookDirs())
+    {
+        auto base = getBookBase(bookDir);
+        // make sure the base is not an actual object
+        if (backend_->cache().get(base, sequence))
+            continue;
+        auto succ = backend_->cache().getSuccessor(base, sequence);
+        if (succ && succ->key == bookDir)
+        {
+            BOOST_LOG_TRIVIAL(debug)
+                << __func__ << " Writing book successor = "
+                << ripple::strHex(base) << " - " << ripple::strHex(bookDir);
+            backend_->writeSuccessor(
+                uint256ToString(base), sequence, uint256ToString(bookDir));
+            ++numWrites;
+        }
+    }
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " - wrote " << numWrites << " successors across ranges";
 }
 
 std::optional<org::xrpl::rpc::v1::GetLedgerResponse>
@@ -988,10 +1202,22 @@ ETLLoadBalancer::fetchLedger(
 {
     org::xrpl::rpc::v1::GetLedgerResponse response;
     bool success = execute(
-        [&response, ledgerSequence, getObjects, getObjectNeighbors](
-            auto& source) {
-            auto [status, data] = source->fetchLedger(
-                ledgerSequence, getObjects, getObjectNeighbors);
+        [this, &response, ledgerSequence, getObjects, getObjectNeighbors](
+            std::size_t sourceIdx) {
+            std::size_t answeredBy = sourceIdx;
+            auto [status, data] = hedgeAfter_.count()
+                ? fetchHedged(
+                      sourceIdx,
+                      ledgerSequence,
+                      getObjects,
+                      getObjectNeighbors,
+                      answeredBy)
+                : fetchFrom(
+                      sourceIdx,
+                      ledgerSequence,
+                      getObjects,
+                      getObjectNeighbors);
+            auto& source = sources_[answeredBy];
             response = std::move(data);
             if (status.ok() && response.validated())
             {
@@ -1013,11 +1239,166 @@ ETLLoadBalancer::fetchLedger(
         },
         ledgerSequence);
     if (success)
+    {
+        if (capture_)
+            capture_->write(
+                ETLCapture::RecordType::LEDGER, ledgerSequence, response);
         return response;
+    }
     else
         return {};
 }
 
+std::vector<std::size_t>
+ETLLoadBalancer::orderSources(uint32_t ledgerSequence) const
+{
+    std::vector<std::size_t> order(sources_.size());
+    // start at a different source for consecutive ledgers, so sources that
+    // look the same are used evenly
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = (ledgerSequence + i) % order.size();
+
+    std::vector<bool> hasLedger(sources_.size());
+    for (std::size_t i = 0; i < sources_.size(); ++i)
+        hasLedger[i] = sources_[i]->hasLedger(ledgerSequence);
+
+    std::vector<double> score(sources_.size());
+    {
+        std::lock_guard lck{statsMtx_};
+        for (std::size_t i = 0; i < stats_.size(); ++i)
+        {
+            // a source that was never used scores 1, so it is tried early
+            auto const& stats = stats_[i];
+            score[i] = (stats.latency.count() + 1.0) * (1 + stats.errors) *
+                (1 + stats.inFlight);
+        }
+    }
+
+    std::stable_sort(
+        order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            if (hasLedger[a] != hasLedger[b])
+                return hasLedger[a] > hasLedger[b];
+            return score[a] < score[b];
+        });
+    return order;
+}
+
+std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
+ETLLoadBalancer::fetchFrom(
+    std::size_t sourceIdx,
+    uint32_t ledgerSequence,
+    bool getObjects,
+    bool getObjectNeighbors)
+{
+    {
+        std::lock_guard lck{statsMtx_};
+        ++stats_[sourceIdx].inFlight;
+    }
+    auto start = std::chrono::system_clock::now();
+    auto res = sources_[sourceIdx]->fetchLedger(
+        ledgerSequence, getObjects, getObjectNeighbors);
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now() - start);
+
+    std::lock_guard lck{statsMtx_};
+    auto& stats = stats_[sourceIdx];
+    --stats.inFlight;
+    if (res.first.ok() && res.second.validated())
+    {
+        stats.latency = stats.latency.count()
+            ? (stats.latency * 7 + latency) / 8
+            : latency;
+        stats.errors /= 2;
+    }
+    else
+    {
+        stats.errors = std::min(stats.errors + 1, 8u);
+    }
+    return res;
+}
+
+std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
+ETLLoadBalancer::fetchHedged(
+    std::size_t sourceIdx,
+    uint32_t ledgerSequence,
+    bool getObjects,
+    bool getObjectNeighbors,
+    std::size_t& answeredBy)
+{
+    struct HedgedFetch
+    {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::size_t numRunning = 0;
+        bool success = false;
+        std::size_t answeredBy = 0;
+        std::optional<
+            std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>>
+            result;
+    };
+    auto state = std::make_shared<HedgedFetch>();
+
+    auto launch = [&](std::size_t idx) {
+        {
+            std::lock_guard lck{hedgeMtx_};
+            ++numHedgesRunning_;
+        }
+        {
+            std::lock_guard lck{state->mtx};
+            ++state->numRunning;
+        }
+        std::thread{[this,
+                     state,
+                     idx,
+                     ledgerSequence,
+                     getObjects,
+                     getObjectNeighbors]() {
+            auto res =
+                fetchFrom(idx, ledgerSequence, getObjects, getObjectNeighbors);
+            bool success = res.first.ok() && res.second.validated();
+            {
+                std::lock_guard lck{state->mtx};
+                --state->numRunning;
+                // keep the first success, or else the last failure
+                if (!state->success)
+                {
+                    state->success = success;
+                    state->answeredBy = idx;
+                    state->result = std::move(res);
+                }
+                state->cv.notify_all();
+            }
+            std::lock_guard lck{hedgeMtx_};
+            --numHedgesRunning_;
+            hedgeCv_.notify_all();
+        }}.detach();
+    };
+
+    auto done = [&state]() { return state->success || !state->numRunning; };
+
+    launch(sourceIdx);
+    std::unique_lock lck{state->mtx};
+    if (!state->cv.wait_for(lck, hedgeAfter_, done))
+    {
+        lck.unlock();
+        for (auto idx : orderSources(ledgerSequence))
+        {
+            if (idx == sourceIdx)
+                continue;
+            BOOST_LOG_TRIVIAL(debug)
+                << __func__ << " : fetch of ledger " << ledgerSequence
+                << " from " << sources_[sourceIdx]->toString()
+                << " is slow. Also fetching from " << sources_[idx]->toString();
+            launch(idx);
+            break;
+        }
+        lck.lock();
+        state->cv.wait(lck, done);
+    }
+    answeredBy = state->answeredBy;
+    return std::move(*state->result);
+}
+
 std::optional<boost::json::object>
 ETLLoadBalancer::forwardToRippled(
     boost::json::object const& request,
@@ -1160,57 +1541,35 @@ template <class Func>
 bool
 ETLLoadBalancer::execute(Func f, uint32_t ledgerSequence)
 {
-    srand((unsigned)time(0));
-    auto sourceIdx = rand() % sources_.size();
-    auto numAttempts = 0;
-
     while (true)
     {
-        auto& source = sources_[sourceIdx];
-
-        BOOST_LOG_TRIVIAL(debug)
-            << __func__ << " : "
-            << "Attempting to execute func. ledger sequence = "
-            << ledgerSequence << " - source = " << source->toString();
-        if (source->hasLedger(ledgerSequence) || true)
+        for (auto sourceIdx : orderSources(ledgerSequence))
         {
-            bool res = f(source);
-            if (res)
+            auto& source = sources_[sourceIdx];
+
+            BOOST_LOG_TRIVIAL(debug)
+                << __func__ << " : "
+                << "Attempting to execute func. ledger sequence = "
+                << ledgerSequence << " - source = " << source->toString();
+            if (f(sourceIdx))
             {
                 BOOST_LOG_TRIVIAL(debug)
                     << __func__ << " : "
                     << "Successfully executed func at source = "
                     << source->toString()
                     << " - ledger sequence = " << ledgerSequence;
-                break;
-            }
-            else
-            {
-                BOOST_LOG_TRIVIAL(warning)
-                    << __func__ << " : "
-                    << "Failed to execute func at source = "
-                    << source->toString()
-                    << " - ledger sequence = " << ledgerSequence;
+                return true;
             }
-        }
-        else
-        {
             BOOST_LOG_TRIVIAL(warning)
                 << __func__ << " : "
-                << "Ledger not present at source = " << source->toString()
+                << "Failed to execute func at source = " << source->toString()
                 << " - ledger sequence = " << ledgerSequence;
         }
-        sourceIdx = (sourceIdx + 1) % sources_.size();
-        numAttempts++;
-        if (numAttempts % sources_.size() == 0)
-        {
-            BOOST_LOG_TRIVIAL(error)
-                << __func__ << " : "
-                << "Error executing function "
-                << " - ledger sequence = " << ledgerSequence
-                << " - Tried all sources. Sleeping and trying again";
-            std::this_thread::sleep_for(std::chrono::seconds(2));
-        }
+        BOOST_LOG_TRIVIAL(error)
+            << __func__ << " : "
+            << "Error executing function "
+            << " - ledger sequence = " << ledgerSequence
+            << " - Tried all sources. Sleeping and trying again";
+        std::this_thread::sleep_for(std::chrono::seconds(2));
     }
-    return true;
 }
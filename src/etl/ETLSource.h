@@ -11,9 +11,14 @@
 #include <subscriptions/SubscriptionManager.h>
 
 #include "org/xrpl/rpc/v1/xrp_ledger.grpc.pb.h"
+#include <etl/ETLCapture.h>
 #include <etl/ETLHelpers.h>
 #include <grpcpp/grpcpp.h>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 class ETLLoadBalancer;
 class ETLSource;
 class ProbingETLSource;
@@ -85,6 +90,191 @@ public:
     get(boost::json::object const& command) const;
 };
 
+/// The ranges of the keyspace that are left to download while loading the
+/// initial ledger. Shared by all of the sources that download the ledger at
+/// the same time. A source that fails gives the unfinished part of each of its
+/// ranges back, starting after the last key it received, and the other
+/// sources pick those up
+class InitialLedgerRanges
+{
+public:
+    /// Start of the range, and end of the range (exclusive). An empty end is
+    /// the end of the keyspace
+    using Range = std::pair<ripple::uint256, std::optional<ripple::uint256>>;
+
+private:
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Range> pending_;
+    // sources still downloading, which may give ranges back
+    std::size_t numSources_ = 0;
+    std::vector<std::string> edgeKeys_;
+    std::vector<ripple::uint256> edgeBookDirs_;
+
+public:
+    InitialLedgerRanges(std::vector<ripple::uint256> const& markers)
+    {
+        for (size_t i = 0; i < markers.size(); ++i)
+        {
+            std::optional<ripple::uint256> end;
+            if (i + 1 < markers.size())
+                end = markers[i + 1];
+            pending_.emplace_back(markers[i], end);
+        }
+    }
+
+    /// Called by a source before it starts downloading
+    void
+    addSource()
+    {
+        std::lock_guard lck{mtx_};
+        ++numSources_;
+    }
+
+    /// Called by a source that stops downloading because it failed, after it
+    /// gave back all of its unfinished ranges
+    void
+    removeSource()
+    {
+        std::lock_guard lck{mtx_};
+        --numSources_;
+        cv_.notify_all();
+    }
+
+    /// Take a range to download, if there is one
+    std::optional<Range>
+    pop()
+    {
+        std::lock_guard lck{mtx_};
+        if (pending_.empty())
+            return {};
+        auto range = std::move(pending_.front());
+        pending_.pop_front();
+        return range;
+    }
+
+    /// Called by a source that has finished all of its ranges. Waits until
+    /// another source gives a range back, and returns it. Returns an empty
+    /// optional once no other source is downloading. In that case, the caller
+    /// is removed from the downloading sources
+    std::optional<Range>
+    waitForRange()
+    {
+        std::unique_lock lck{mtx_};
+        --numSources_;
+        cv_.notify_all();
+        cv_.wait(lck, [this]() {
+            return !pending_.empty() || numSources_ == 0;
+        });
+        if (pending_.empty())
+            return {};
+        ++numSources_;
+        auto range = std::move(pending_.front());
+        pending_.pop_front();
+        return range;
+    }
+
+    /// Give back a range that was not downloaded
+    void
+    push(Range range)
+    {
+        std::lock_guard lck{mtx_};
+        pending_.push_back(std::move(range));
+        cv_.notify_all();
+    }
+
+    /// Whether all of the ranges were taken. Once every source has returned,
+    /// this means the whole ledger was downloaded
+    bool
+    empty() const
+    {
+        std::lock_guard lck{mtx_};
+        return pending_.empty();
+    }
+
+    /// Record the last key written by a range. Its successor is in another
+    /// range, and is written once the download is complete
+    void
+    addEdgeKey(std::string key)
+    {
+        std::lock_guard lck{mtx_};
+        edgeKeys_.push_back(std::move(key));
+    }
+
+    std::vector<std::string>
+    getEdgeKeys() const
+    {
+        std::lock_guard lck{mtx_};
+        return edgeKeys_;
+    }
+
+    /// Record a book directory that was the first object of a range, while
+    /// the base of its book is in an earlier range. Whether the base points to
+    /// it is known once the download is complete
+    void
+    addEdgeBookDir(ripple::uint256 const& key)
+    {
+        std::lock_guard lck{mtx_};
+        edgeBookDirs_.push_back(key);
+    }
+
+    std::vector<ripple::uint256>
+    getEdgeBookDirs() const
+    {
+        std::lock_guard lck{mtx_};
+        return edgeBookDirs_;
+    }
+};
+
+/// Writes the objects of one range of the initial ledger, in key order, along
+/// with the successor of each object, and the book bases that point to a
+/// directory in the range
+class InitialLedgerRangeWriter
+{
+    BackendInterface& backend_;
+    std::uint32_t sequence_;
+    // start of the range
+    ripple::uint256 start_;
+    // last key written. The successor of the first key written is only known
+    // here if the range starts at the beginning of the keyspace
+    std::string lastKey_;
+    // book directory whose previous object is in another range
+    std::optional<ripple::uint256> edgeBookDir_;
+
+    /// The base of a book points to the first directory of the book, which
+    /// is this directory if the previous object is before the base. If this
+    /// is the first object of the range, and the base is before the range,
+    /// the previous object is only known once all ranges are downloaded
+    void
+    writeBookBase(ripple::uint256 const& key);
+
+public:
+    InitialLedgerRangeWriter(
+        BackendInterface& backend,
+        std::uint32_t sequence,
+        ripple::uint256 const& start);
+
+    /// Write an object. Objects must be written in key order
+    void
+    write(
+        ripple::uint256 const& key,
+        std::string&& keyBytes,
+        std::string&& blob);
+
+    /// Last key written, whose successor is in another range
+    std::string const&
+    getLastKey() const
+    {
+        return lastKey_;
+    }
+
+    std::optional<ripple::uint256>
+    getEdgeBookDir() const
+    {
+        return edgeBookDir_;
+    }
+};
+
 class ETLSource
 {
 public:
@@ -118,6 +308,7 @@ public:
     virtual bool
     loadInitialLedger(
         uint32_t sequence,
+        InitialLedgerRanges& ranges,
         std::uint32_t numMarkers,
         bool cacheOnly = false) = 0;
 
@@ -424,13 +615,16 @@ public:
         return res;
     }
 
-    /// Download a ledger in full
+    /// Download ranges of a ledger, until no ranges are left
     /// @param ledgerSequence sequence of the ledger to download
-    /// @param writeQueue queue to push downloaded ledger objects
-    /// @return true if the download was successful
+    /// @param ranges ranges to download, shared with the other sources
+    /// @param numMarkers number of ranges downloaded at the same time
+    /// @return true if the download was successful. If false, the ranges that
+    /// were not finished have been given back
     bool
     loadInitialLedger(
         std::uint32_t ledgerSequence,
+        InitialLedgerRanges& ranges,
         std::uint32_t numMarkers,
         bool cacheOnly = false) override;
 
@@ -605,9 +799,38 @@ class ETLLoadBalancer
 {
 private:
     std::vector<std::unique_ptr<ETLSource>> sources_;
+    std::shared_ptr<BackendInterface> backend_;
 
     std::uint32_t downloadRanges_ = 16;
 
+    // if set, every ledger fetched and every page of the initial ledger is
+    // recorded, to be replayed later with ReplayETLSource
+    std::unique_ptr<ETLCapture> capture_;
+
+    // how each source has been doing when fetching ledgers. Used to try the
+    // fastest source first
+    struct SourceStats
+    {
+        // moving average of the time taken by successful fetches
+        std::chrono::microseconds latency{0};
+        // recent failed fetches. Halved on every successful fetch
+        std::uint32_t errors = 0;
+        // fetches currently running
+        std::uint32_t inFlight = 0;
+    };
+    mutable std::mutex statsMtx_;
+    std::vector<SourceStats> stats_;
+
+    // if nonzero, a fetch that takes longer than this is also sent to the
+    // next best source, and the first answer is used
+    std::chrono::milliseconds hedgeAfter_{0};
+
+    // hedged fetches that are still running. They reference this object, so
+    // they are waited for on destruction
+    std::mutex hedgeMtx_;
+    std::condition_variable hedgeCv_;
+    std::size_t numHedgesRunning_ = 0;
+
 public:
     ETLLoadBalancer(
         boost::json::object const& config,
@@ -630,10 +853,21 @@ public:
 
     ~ETLLoadBalancer()
     {
+        std::unique_lock lck{hedgeMtx_};
+        hedgeCv_.wait(lck, [this]() { return numHedgesRunning_ == 0; });
+        lck.unlock();
         sources_.clear();
     }
 
-    /// Load the initial ledger, writing data to the queue
+    /// Where the responses of the sources are recorded, if anywhere
+    ETLCapture*
+    getCapture()
+    {
+        return capture_.get();
+    }
+
+    /// Load the initial ledger, downloading from all of the sources at once.
+    /// Ranges of a source that fails are finished by the other sources
     /// @param sequence sequence of ledger to download
     void
     loadInitialLedger(uint32_t sequence, bool cacheOnly = false);
@@ -701,14 +935,41 @@ public:
         boost::asio::yield_context& yield) const;
 
 private:
-    /// f is a function that takes an ETLSource as an argument and returns a
-    /// bool. Attempt to execute f for one randomly chosen ETLSource that has
-    /// the specified ledger. If f returns false, another randomly chosen
-    /// ETLSource is used. The process repeats until f returns true.
-    /// @param f function to execute. This function takes the ETL source as an
-    /// argument, and returns a bool.
-    /// @param ledgerSequence f is executed for each ETLSource that has this
-    /// ledger
+    /// Indexes of the sources to try for a ledger, best first. Sources that
+    /// have the ledger come before the ones that don't, which are still tried
+    /// since a source may not have reported a newly validated ledger yet.
+    /// Then, sources are ordered by how fast they have been, how often they
+    /// failed, and how many fetches they are currently running
+    std::vector<std::size_t>
+    orderSources(uint32_t ledgerSequence) const;
+
+    /// Fetch a ledger from a single source, and record how long it took
+    std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
+    fetchFrom(
+        std::size_t sourceIdx,
+        uint32_t ledgerSequence,
+        bool getObjects,
+        bool getObjectNeighbors);
+
+    /// Fetch a ledger from a source. If it takes longer than hedgeAfter_, send
+    /// the same fetch to the next best source, and return whichever succeeds
+    /// first
+    /// @param answeredBy set to the index of the source that answered
+    std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
+    fetchHedged(
+        std::size_t sourceIdx,
+        uint32_t ledgerSequence,
+        bool getObjects,
+        bool getObjectNeighbors,
+        std::size_t& answeredBy);
+
+    /// f is a function that takes the index of an ETLSource as an argument and
+    /// returns a bool. Attempt to execute f for the best ETLSource for the
+    /// specified ledger. If f returns false, the next best ETLSource is used.
+    /// The process repeats until f returns true.
+    /// @param f function to execute. This function takes the index of the ETL
+    /// source as an argument, and returns a bool.
+    /// @param ledgerSequence sequence of the ledger, used to order sources
     /// @return true if f was eventually executed successfully. false if the
     /// ledger was found in the database or the server is shutting down
     template <class Func>
@@ -92,13 +92,14 @@ ProbingETLSource::toString() const
 bool
 ProbingETLSource::loadInitialLedger(
     std::uint32_t ledgerSequence,
+    InitialLedgerRanges& ranges,
     std::uint32_t numMarkers,
     bool cacheOnly)
 {
     if (!currentSrc_)
         return false;
     return currentSrc_->loadInitialLedger(
-        ledgerSequence, numMarkers, cacheOnly);
+        ledgerSequence, ranges, numMarkers, cacheOnly);
 }
 
 std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
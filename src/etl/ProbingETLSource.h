@@ -58,6 +58,7 @@ public:
     bool
     loadInitialLedger(
         std::uint32_t ledgerSequence,
+        InitialLedgerRanges& ranges,
         std::uint32_t numMarkers,
         bool cacheOnly = false) override;
 
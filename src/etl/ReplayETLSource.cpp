@@ -0,0 +1,204 @@
+#include <boost/log/trivial.hpp>
+#include <etl/ReplayETLSource.h>
+
+#include <algorithm>
+
+ReplayETLSource::ReplayETLSource(
+    boost::json::object const& config,
+    std::shared_ptr<BackendInterface> backend,
+    std::shared_ptr<NetworkValidatedLedgers> nwvl)
+    : reader_(config.at("replay_file").as_string().c_str())
+    , ledgers_(reader_.getLedgers())
+    , backend_(backend)
+    , networkValidatedLedgers_(nwvl)
+{
+    if (config.contains("replay_timing"))
+    {
+        auto const& timing = config.at("replay_timing");
+        if (!timing.is_string() ||
+            (timing != "recorded" && timing != "full_speed"))
+            throw std::runtime_error(
+                "replay_timing must be \"recorded\" or \"full_speed\"");
+        recordedTiming_ = timing == "recorded";
+    }
+    BOOST_LOG_TRIVIAL(info) << __func__ << " : replaying " << ledgers_.size()
+                            << " ledgers from " << reader_.getPath();
+}
+
+ReplayETLSource::~ReplayETLSource()
+{
+    {
+        std::lock_guard lck{mtx_};
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (timer_.joinable())
+        timer_.join();
+}
+
+void
+ReplayETLSource::run()
+{
+    auto first = reader_.getFirstSequence();
+    if (!first)
+        return;
+    networkValidatedLedgers_->push(*first);
+
+    if (!recordedTiming_ || ledgers_.empty())
+        return;
+
+    timer_ = std::thread{[this]() {
+        auto start = std::chrono::steady_clock::now();
+        auto firstMicros = ledgers_.front().second;
+        for (auto const& [sequence, micros] : ledgers_)
+        {
+            std::unique_lock lck{mtx_};
+            if (cv_.wait_until(
+                    lck,
+                    start + std::chrono::microseconds{micros - firstMicros},
+                    [this]() { return stopping_; }))
+                return;
+            networkValidatedLedgers_->push(sequence);
+        }
+    }};
+}
+
+void
+ReplayETLSource::validateNext(std::uint32_t sequence)
+{
+    auto next = std::upper_bound(
+        ledgers_.begin(),
+        ledgers_.end(),
+        sequence,
+        [](std::uint32_t seq, auto const& ledger) {
+            return seq < ledger.first;
+        });
+    if (next != ledgers_.end())
+        networkValidatedLedgers_->push(next->first);
+}
+
+bool
+ReplayETLSource::hasLedger(uint32_t sequence) const
+{
+    auto it = std::lower_bound(
+        ledgers_.begin(),
+        ledgers_.end(),
+        sequence,
+        [](auto const& ledger, std::uint32_t seq) {
+            return ledger.first < seq;
+        });
+    if (it != ledgers_.end() && it->first == sequence)
+        return true;
+    return reader_.hasLedgerData(sequence);
+}
+
+boost::json::object
+ReplayETLSource::toJson() const
+{
+    boost::json::object res;
+    if (!ledgers_.empty())
+        res["validated_range"] = std::to_string(ledgers_.front().first) + "-" +
+            std::to_string(ledgers_.back().first);
+    res["is_connected"] = std::to_string(isConnected());
+    res["replay_file"] = reader_.getPath();
+    return res;
+}
+
+bool
+ReplayETLSource::loadInitialLedger(
+    std::uint32_t ledgerSequence,
+    InitialLedgerRanges& ranges,
+    std::uint32_t numMarkers,
+    bool cacheOnly)
+{
+    // only a download that completed while capturing holds all of the
+    // objects of the ledger
+    if (!reader_.hasLedgerData(ledgerSequence))
+    {
+        BOOST_LOG_TRIVIAL(error)
+            << __func__ << " : the initial download of ledger "
+            << ledgerSequence << " is not complete in " << reader_.getPath();
+        return false;
+    }
+
+    // the recording holds the whole ledger, so all of the ranges are done
+    // here, as a single range
+    while (ranges.pop())
+        ;
+
+    struct Object
+    {
+        ripple::uint256 key;
+        std::string keyBytes;
+        std::string blob;
+    };
+    std::vector<Object> objects;
+    for (auto const& page : reader_.getLedgerData(ledgerSequence))
+    {
+        org::xrpl::rpc::v1::GetLedgerDataResponse response;
+        if (!response.ParseFromString(page))
+            throw std::runtime_error(
+                "Corrupt capture file " + reader_.getPath());
+        for (auto& obj : *response.mutable_ledger_objects()->mutable_objects())
+        {
+            auto key = ripple::uint256::fromVoidChecked(obj.key());
+            assert(key);
+            objects.push_back(
+                {*key,
+                 std::move(*obj.mutable_key()),
+                 std::move(*obj.mutable_data())});
+        }
+    }
+    // ranges that were split or retried while recording were received more
+    // than once
+    std::sort(
+        objects.begin(), objects.end(), [](auto const& a, auto const& b) {
+            return a.key < b.key;
+        });
+    objects.erase(
+        std::unique(
+            objects.begin(),
+            objects.end(),
+            [](auto const& a, auto const& b) { return a.key == b.key; }),
+        objects.end());
+
+    InitialLedgerRangeWriter writer{
+        *backend_, ledgerSequence, ripple::uint256{0}};
+    std::vector<Backend::LedgerObject> cacheUpdates;
+    for (auto& obj : objects)
+    {
+        cacheUpdates.push_back({obj.key, {obj.blob.begin(), obj.blob.end()}});
+        if (!cacheOnly)
+            writer.write(obj.key, std::move(obj.keyBytes), std::move(obj.blob));
+        if (cacheUpdates.size() == 10000)
+        {
+            backend_->cache().update(cacheUpdates, ledgerSequence, cacheOnly);
+            cacheUpdates.clear();
+        }
+    }
+    backend_->cache().update(cacheUpdates, ledgerSequence, cacheOnly);
+
+    if (writer.getLastKey().size())
+        ranges.addEdgeKey(writer.getLastKey());
+    BOOST_LOG_TRIVIAL(info) << __func__ << " : replayed " << objects.size()
+                            << " objects of ledger " << ledgerSequence;
+    return true;
+}
+
+std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
+ReplayETLSource::fetchLedger(
+    uint32_t ledgerSequence,
+    bool getObjects,
+    bool getObjectNeighbors)
+{
+    org::xrpl::rpc::v1::GetLedgerResponse response;
+    auto data = reader_.getLedger(ledgerSequence);
+    if (!data)
+        return {{grpc::StatusCode::NOT_FOUND, "Not in capture"}, response};
+    if (!response.ParseFromString(*data))
+        return {{grpc::StatusCode::INTERNAL, "Corrupt capture"}, response};
+
+    if (!recordedTiming_)
+        validateNext(ledgerSequence);
+    return {grpc::Status::OK, std::move(response)};
+}
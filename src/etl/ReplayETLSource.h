@@ -0,0 +1,110 @@
+#ifndef CLIO_REPLAYETLSOURCE_H_INCLUDED
+#define CLIO_REPLAYETLSOURCE_H_INCLUDED
+
+#include <etl/ETLCapture.h>
+#include <etl/ETLSource.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/// This ETLSource implementation replays a file recorded with ETLCapture
+/// instead of connecting to a rippled node, so the ETL can be measured
+/// without a network. Ledgers are returned as they were recorded, whatever
+/// objects were asked for. The first recorded ledger is reported as validated
+/// right away. The following ledgers are reported as validated either as soon
+/// as the previous one is fetched, or at the times they were recorded at, if
+/// replay_timing is "recorded"
+class ReplayETLSource : public ETLSource
+{
+    ETLCaptureReader reader_;
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> ledgers_;
+
+    std::shared_ptr<BackendInterface> backend_;
+    std::shared_ptr<NetworkValidatedLedgers> networkValidatedLedgers_;
+
+    bool recordedTiming_ = false;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread timer_;
+
+    /// Report the ledger recorded after sequence as validated
+    void
+    validateNext(std::uint32_t sequence);
+
+public:
+    ReplayETLSource(
+        boost::json::object const& config,
+        std::shared_ptr<BackendInterface> backend,
+        std::shared_ptr<NetworkValidatedLedgers> nwvl);
+
+    ~ReplayETLSource();
+
+    void
+    run() override;
+
+    void
+    pause() override
+    {
+    }
+
+    void
+    resume() override
+    {
+    }
+
+    bool
+    isConnected() const override
+    {
+        return true;
+    }
+
+    bool
+    hasLedger(uint32_t sequence) const override;
+
+    boost::json::object
+    toJson() const override;
+
+    std::string
+    toString() const override
+    {
+        return "{ replay: " + reader_.getPath() + " }";
+    }
+
+    bool
+    loadInitialLedger(
+        std::uint32_t ledgerSequence,
+        InitialLedgerRanges& ranges,
+        std::uint32_t numMarkers,
+        bool cacheOnly = false) override;
+
+    std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
+    fetchLedger(
+        uint32_t ledgerSequence,
+        bool getObjects = true,
+        bool getObjectNeighbors = false) override;
+
+    std::optional<boost::json::object>
+    forwardToRippled(
+        boost::json::object const& request,
+        std::string const& clientIp,
+        boost::asio::yield_context& yield) const override
+    {
+        return {};
+    }
+
+private:
+    std::optional<boost::json::object>
+    requestFromRippled(
+        boost::json::object const& request,
+        std::string const& clientIp,
+        boost::asio::yield_context& yield) const override
+    {
+        return {};
+    }
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <cstdlib>
+#include <future>
 #include <iostream>
 #include <string>
 #include <subscriptions/SubscriptionManager.h>
@@ -31,41 +32,126 @@ toString(ripple::LedgerInfo const& info)
 FormattedTransactionsData
 ReportingETL::insertTransactions(
     ripple::LedgerInfo const& ledger,
-    org::xrpl::rpc::v1::GetLedgerResponse& data)
+    org::xrpl::rpc::v1::GetLedgerResponse& data,
+    bool keepTransactions)
 {
-    FormattedTransactionsData result;
+    auto& txns = *(data.mutable_transactions_list()->mutable_transactions());
+
+    // Deserializes, extracts and writes the transactions in [begin, end).
+    // Each chunk only touches its own transactions and its own result, so
+    // chunks can be processed concurrently.
+    auto transformChunk = [this, &ledger, &txns, keepTransactions](
+                              int begin,
+                              int end,
+                              FormattedTransactionsData& chunkResult) {
+        for (int i = begin; i < end; ++i)
+        {
+            auto& txn = txns[i];
+            std::string* raw = txn.mutable_transaction_blob();
 
-    for (auto& txn :
-         *(data.mutable_transactions_list()->mutable_transactions()))
-    {
-        std::string* raw = txn.mutable_transaction_blob();
+            ripple::SerialIter it{raw->data(), raw->size()};
+            ripple::STTx sttx{it};
 
-        ripple::SerialIter it{raw->data(), raw->size()};
-        ripple::STTx sttx{it};
+            BOOST_LOG_TRIVIAL(trace)
+                << __func__ << " : "
+                << "Inserting transaction = " << sttx.getTransactionID();
+
+            ripple::TxMeta txMeta{
+                sttx.getTransactionID(), ledger.seq, txn.metadata_blob()};
+
+            auto const [nftTxs, maybeNFT] = getNFTData(txMeta, sttx);
+            chunkResult.nfTokenTxData.insert(
+                chunkResult.nfTokenTxData.end(), nftTxs.begin(), nftTxs.end());
+            if (maybeNFT)
+                chunkResult.nfTokensData.push_back(*maybeNFT);
+
+            auto journal = ripple::debugLog();
+            chunkResult.accountTxData.emplace_back(
+                txMeta, sttx.getTransactionID(), journal);
+            std::string keyStr{
+                (const char*)sttx.getTransactionID().data(), 32};
+            if (keepTransactions)
+                chunkResult.transactions.push_back(
+                    {{raw->begin(), raw->end()},
+                     {txn.metadata_blob().begin(), txn.metadata_blob().end()},
+                     ledger.seq,
+                     static_cast<std::uint32_t>(
+                         ledger.closeTime.time_since_epoch().count())});
+            backend_->writeTransaction(
+                std::move(keyStr),
+                ledger.seq,
+                ledger.closeTime.time_since_epoch().count(),
+                std::move(*raw),
+                std::move(*txn.mutable_metadata_blob()));
+        }
+    };
 
-        BOOST_LOG_TRIVIAL(trace)
-            << __func__ << " : "
-            << "Inserting transaction = " << sttx.getTransactionID();
-
-        ripple::TxMeta txMeta{
-            sttx.getTransactionID(), ledger.seq, txn.metadata_blob()};
-
-        auto const [nftTxs, maybeNFT] = getNFTData(txMeta, sttx);
-        result.nfTokenTxData.insert(
-            result.nfTokenTxData.end(), nftTxs.begin(), nftTxs.end());
-        if (maybeNFT)
-            result.nfTokensData.push_back(*maybeNFT);
-
-        auto journal = ripple::debugLog();
-        result.accountTxData.emplace_back(
-            txMeta, sttx.getTransactionID(), journal);
-        std::string keyStr{(const char*)sttx.getTransactionID().data(), 32};
-        backend_->writeTransaction(
-            std::move(keyStr),
-            ledger.seq,
-            ledger.closeTime.time_since_epoch().count(),
-            std::move(*raw),
-            std::move(*txn.mutable_metadata_blob()));
+    int const numTxns = txns.size();
+    size_t numChunks = std::min<size_t>(
+        transformThreads_,
+        (numTxns + minTxnsPerTransformChunk_ - 1) / minTxnsPerTransformChunk_);
+    if (numChunks == 0)
+        numChunks = 1;
+
+    std::vector<FormattedTransactionsData> chunkResults(numChunks);
+    auto chunkBegin = [&](size_t chunk) { return numTxns * chunk / numChunks; };
+
+    // The first chunk is processed on the calling thread, the rest on the
+    // transform pool
+    std::vector<std::future<void>> pending;
+    pending.reserve(numChunks - 1);
+    for (size_t chunk = 1; chunk < numChunks; ++chunk)
+    {
+        auto task = std::make_shared<std::packaged_task<void()>>(
+            [&, chunk]() {
+                transformChunk(
+                    chunkBegin(chunk),
+                    chunkBegin(chunk + 1),
+                    chunkResults[chunk]);
+            });
+        pending.push_back(task->get_future());
+        boost::asio::post(*transformPool_, [task]() { (*task)(); });
+    }
+    std::exception_ptr error;
+    try
+    {
+        transformChunk(chunkBegin(0), chunkBegin(1), chunkResults[0]);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    // Always wait for every chunk, since they reference this stack frame
+    for (auto& f : pending)
+    {
+        try
+        {
+            f.get();
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+
+    // Concatenate the chunks in transaction order, so the result is the same
+    // as if the transactions were processed sequentially
+    FormattedTransactionsData result = std::move(chunkResults[0]);
+    auto append = [](auto& a, auto& b) {
+        a.insert(
+            a.end(),
+            std::make_move_iterator(b.begin()),
+            std::make_move_iterator(b.end()));
+    };
+    for (size_t chunk = 1; chunk < numChunks; ++chunk)
+    {
+        append(result.accountTxData, chunkResults[chunk].accountTxData);
+        append(result.nfTokenTxData, chunkResults[chunk].nfTokenTxData);
+        append(result.nfTokensData, chunkResults[chunk].nfTokensData);
+        append(result.transactions, chunkResults[chunk].transactions);
     }
 
     // Remove all but the last NFTsData for each id. unique removes all
@@ -156,11 +242,29 @@ ReportingETL::loadInitialLedger(uint32_t startingSequence)
 }
 
 void
-ReportingETL::publishLedger(ripple::LedgerInfo const& lgrInfo)
+ReportingETL::publishLedger(
+    ripple::LedgerInfo const& lgrInfo,
+    std::optional<std::vector<Backend::TransactionAndMetadata>> transactions,
+    std::optional<ripple::Fees> fees)
 {
     BOOST_LOG_TRIVIAL(debug)
         << __func__ << " - Publishing ledger " << std::to_string(lgrInfo.seq);
 
+    setLastClose(lgrInfo.closeTime);
+    auto age = lastCloseAgeSeconds();
+    // if the ledger closed over 10 minutes ago, assume we are still
+    // catching up and don't publish
+    bool publish = age < 600;
+
+    // start fetching the transactions while the cache is updated. The fees
+    // are read after, as they can then come from the cache
+    std::future<std::vector<Backend::TransactionAndMetadata>> txFuture;
+    if (publish && !transactions)
+        txFuture = Backend::spawnFutureAndRetryOnTimeout(
+            [this, seq = lgrInfo.seq](auto yield) {
+                return backend_->fetchAllTransactionsInLedger(seq, yield);
+            });
+
     if (!writing_)
     {
         BOOST_LOG_TRIVIAL(debug) << __func__ << " - Updating cache";
@@ -174,22 +278,15 @@ ReportingETL::publishLedger(ripple::LedgerInfo const& lgrInfo)
         backend_->updateRange(lgrInfo.seq);
     }
 
-    setLastClose(lgrInfo.closeTime);
-    auto age = lastCloseAgeSeconds();
-    // if the ledger closed over 10 minutes ago, assume we are still
-    // catching up and don't publish
-    if (age < 600)
+    if (publish)
     {
-        std::optional<ripple::Fees> fees =
-            Backend::synchronousAndRetryOnTimeout([&](auto yield) {
+        if (!fees)
+            fees = Backend::synchronousAndRetryOnTimeout([&](auto yield) {
                 return backend_->fetchFees(lgrInfo.seq, yield);
             });
 
-        std::vector<Backend::TransactionAndMetadata> transactions =
-            Backend::synchronousAndRetryOnTimeout([&](auto yield) {
-                return backend_->fetchAllTransactionsInLedger(
-                    lgrInfo.seq, yield);
-            });
+        if (!transactions)
+            transactions = txFuture.get();
 
         auto ledgerRange = backend_->fetchLedgerRange();
         assert(ledgerRange);
@@ -198,12 +295,11 @@ ReportingETL::publishLedger(ripple::LedgerInfo const& lgrInfo)
         std::string range = std::to_string(ledgerRange->minSequence) + "-" +
             std::to_string(ledgerRange->maxSequence);
 
-        subscriptions_->pubLedger(lgrInfo, *fees, range, transactions.size());
+        subscriptions_->pubLedger(lgrInfo, *fees, range, transactions->size());
 
-        for (auto& txAndMeta : transactions)
-            subscriptions_->pubTransaction(txAndMeta, lgrInfo);
+        subscriptions_->pubTransactions(*transactions, lgrInfo);
 
-        subscriptions_->pubBookChanges(lgrInfo, transactions);
+        subscriptions_->pubBookChanges(lgrInfo, *transactions);
 
         BOOST_LOG_TRIVIAL(info) << __func__ << " - Published ledger "
                                 << std::to_string(lgrInfo.seq);
@@ -297,14 +393,23 @@ ReportingETL::fetchLedgerDataAndDiff(uint32_t seq)
     return response;
 }
 
-std::pair<ripple::LedgerInfo, bool>
-ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
+BuiltLedger
+ReportingETL::buildNextLedger(
+    org::xrpl::rpc::v1::GetLedgerResponse& rawData,
+    bool isBackfill)
 {
     BOOST_LOG_TRIVIAL(debug) << __func__ << " : "
                              << "Beginning ledger update";
 
-    ripple::LedgerInfo lgrInfo =
-        deserializeHeader(ripple::makeSlice(rawData.ledger_header()));
+    // ledgers are backfilled out of order, so the cache can't be used to
+    // compute successors, and must not be updated
+    if (isBackfill && !rawData.object_neighbors_included())
+        throw std::runtime_error(
+            "Backfilled ledgers must include object neighbors");
+
+    BuiltLedger result;
+    ripple::LedgerInfo& lgrInfo = result.lgrInfo;
+    lgrInfo = deserializeHeader(ripple::makeSlice(rawData.ledger_header()));
 
     BOOST_LOG_TRIVIAL(debug)
         << __func__ << " : "
@@ -387,9 +492,11 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
     }
     std::vector<Backend::LedgerObject> cacheUpdates;
     cacheUpdates.reserve(rawData.ledger_objects().objects_size());
-    // TODO change these to unordered_set
-    std::set<ripple::uint256> bookSuccessorsToCalculate;
-    std::set<ripple::uint256> modified;
+    // created or deleted objects (and whether they were deleted), and book
+    // bases whose first directory changed. Only used when rippled doesn't
+    // send neighbors
+    std::vector<std::pair<ripple::uint256, bool>> createdOrDeleted;
+    std::vector<ripple::uint256> bookSuccessorsToCalculate;
     for (auto& obj : *(rawData.mutable_ledger_objects()->mutable_objects()))
     {
         auto key = ripple::uint256::fromVoidChecked(obj.key());
@@ -399,6 +506,9 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
         BOOST_LOG_TRIVIAL(debug)
             << __func__ << " key = " << ripple::strHex(*key)
             << " - mod type = " << obj.mod_type();
+        if (!isBackfill && *key == ripple::keylet::fees().key &&
+            obj.data().size())
+            result.fees = deserializeFees(obj.data());
 
         if (obj.mod_type() != org::xrpl::rpc::v1::RawLedgerObject::MODIFIED &&
             !rawData.object_neighbors_included())
@@ -442,19 +552,19 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
                         << " - key = " << ripple::strHex(*key)
                         << " - isDeleted = " << isDeleted
                         << " - seq = " << lgrInfo.seq;
-                    bookSuccessorsToCalculate.insert(bookBase);
+                    bookSuccessorsToCalculate.push_back(bookBase);
                 }
             }
+            createdOrDeleted.emplace_back(*key, isDeleted);
         }
-        if (obj.mod_type() == org::xrpl::rpc::v1::RawLedgerObject::MODIFIED)
-            modified.insert(*key);
 
         backend_->writeLedgerObject(
             std::move(*obj.mutable_key()),
             lgrInfo.seq,
             std::move(*obj.mutable_data()));
     }
-    backend_->cache().update(cacheUpdates, lgrInfo.seq);
+    if (!isBackfill)
+        backend_->cache().update(cacheUpdates, lgrInfo.seq);
     // rippled didn't send successor information, so use our cache
     if (!rawData.object_neighbors_included())
     {
@@ -465,75 +575,89 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
             throw std::runtime_error(
                 "Cache is not full, but object neighbors were not "
                 "included");
-        for (auto const& obj : cacheUpdates)
+        auto start = std::chrono::system_clock::now();
+        std::sort(createdOrDeleted.begin(), createdOrDeleted.end());
+        std::sort(
+            bookSuccessorsToCalculate.begin(), bookSuccessorsToCalculate.end());
+        bookSuccessorsToCalculate.erase(
+            std::unique(
+                bookSuccessorsToCalculate.begin(),
+                bookSuccessorsToCalculate.end()),
+            bookSuccessorsToCalculate.end());
+
+        // Look up the neighbors of every key in one sorted pass over the
+        // cache, rather than descending the cache twice per key. Objects come
+        // before book bases when a key is both
+        std::vector<ripple::uint256> keys;
+        keys.reserve(
+            createdOrDeleted.size() + bookSuccessorsToCalculate.size());
+        auto objIt = createdOrDeleted.begin();
+        auto baseIt = bookSuccessorsToCalculate.begin();
+        while (objIt != createdOrDeleted.end() ||
+               baseIt != bookSuccessorsToCalculate.end())
         {
-            if (modified.count(obj.key))
+            if (baseIt == bookSuccessorsToCalculate.end() ||
+                (objIt != createdOrDeleted.end() && objIt->first <= *baseIt))
+                keys.push_back((objIt++)->first);
+            else
+                keys.push_back(*baseIt++);
+        }
+        auto neighbors = backend_->cache().getNeighbors(keys, lgrInfo.seq);
+        assert(neighbors.size() == keys.size());
+
+        // Adjacent created or deleted objects produce the same successor
+        // record more than once, so collect the records and write each once
+        std::vector<std::pair<ripple::uint256, ripple::uint256>> successors;
+        successors.reserve(2 * keys.size());
+        objIt = createdOrDeleted.begin();
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            auto const& key = keys[i];
+            auto lb = neighbors[i].first.value_or(Backend::firstKey);
+            auto ub = neighbors[i].second.value_or(Backend::lastKey);
+            if (objIt == createdOrDeleted.end() || objIt->first != key)
+            {
+                BOOST_LOG_TRIVIAL(debug)
+                    << __func__ << " Updating book successor "
+                    << ripple::strHex(key) << " - " << ripple::strHex(ub);
+                successors.emplace_back(key, ub);
                 continue;
-            auto lb = backend_->cache().getPredecessor(obj.key, lgrInfo.seq);
-            if (!lb)
-                lb = {Backend::firstKey, {}};
-            auto ub = backend_->cache().getSuccessor(obj.key, lgrInfo.seq);
-            if (!ub)
-                ub = {Backend::lastKey, {}};
-            if (obj.blob.size() == 0)
+            }
+            bool isDeleted = (objIt++)->second;
+            if (isDeleted)
             {
                 BOOST_LOG_TRIVIAL(debug)
                     << __func__ << " writing successor for deleted object "
-                    << ripple::strHex(obj.key) << " - "
-                    << ripple::strHex(lb->key) << " - "
-                    << ripple::strHex(ub->key);
-
-                backend_->writeSuccessor(
-                    uint256ToString(lb->key),
-                    lgrInfo.seq,
-                    uint256ToString(ub->key));
+                    << ripple::strHex(key) << " - " << ripple::strHex(lb)
+                    << " - " << ripple::strHex(ub);
+
+                successors.emplace_back(lb, ub);
             }
             else
             {
-                backend_->writeSuccessor(
-                    uint256ToString(lb->key),
-                    lgrInfo.seq,
-                    uint256ToString(obj.key));
-                backend_->writeSuccessor(
-                    uint256ToString(obj.key),
-                    lgrInfo.seq,
-                    uint256ToString(ub->key));
-
                 BOOST_LOG_TRIVIAL(debug)
                     << __func__ << " writing successor for new object "
-                    << ripple::strHex(lb->key) << " - "
-                    << ripple::strHex(obj.key) << " - "
-                    << ripple::strHex(ub->key);
+                    << ripple::strHex(lb) << " - " << ripple::strHex(key)
+                    << " - " << ripple::strHex(ub);
+
+                successors.emplace_back(lb, key);
+                successors.emplace_back(key, ub);
             }
         }
-        for (auto const& base : bookSuccessorsToCalculate)
+        std::sort(successors.begin(), successors.end());
+        successors.erase(
+            std::unique(successors.begin(), successors.end()),
+            successors.end());
+        for (auto const& [key, successor] : successors)
         {
-            auto succ = backend_->cache().getSuccessor(base, lgrInfo.seq);
-            if (succ)
-            {
-                backend_->writeSuccessor(
-                    uint256ToString(base),
-                    lgrInfo.seq,
-                    uint256ToString(succ->key));
-
-                BOOST_LOG_TRIVIAL(debug)
-                    << __func__ << " Updating book successor "
-                    << ripple::strHex(base) << " - "
-                    << ripple::strHex(succ->key);
-            }
-            else
-            {
-                backend_->writeSuccessor(
-                    uint256ToString(base),
-                    lgrInfo.seq,
-                    uint256ToString(Backend::lastKey));
-
-                BOOST_LOG_TRIVIAL(debug)
-                    << __func__ << " Updating book successor "
-                    << ripple::strHex(base) << " - "
-                    << ripple::strHex(Backend::lastKey);
-            }
+            backend_->writeSuccessor(
+                uint256ToString(key), lgrInfo.seq, uint256ToString(successor));
         }
+        auto end = std::chrono::system_clock::now();
+        BOOST_LOG_TRIVIAL(debug)
+            << __func__ << " computed " << successors.size()
+            << " successors for " << keys.size() << " keys. took "
+            << ((end - start).count()) / 1000000000.0;
     }
 
     BOOST_LOG_TRIVIAL(debug)
@@ -541,7 +665,8 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
         << "Inserted/modified/deleted all objects. Number of objects = "
         << rawData.ledger_objects().objects_size();
     FormattedTransactionsData insertTxResult =
-        insertTransactions(lgrInfo, rawData);
+        insertTransactions(lgrInfo, rawData, !isBackfill);
+    result.transactions = std::move(insertTxResult.transactions);
     BOOST_LOG_TRIVIAL(debug)
         << __func__ << " : "
         << "Inserted all transactions. Number of transactions  = "
@@ -551,20 +676,11 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
     backend_->writeNFTTransactions(std::move(insertTxResult.nfTokenTxData));
     BOOST_LOG_TRIVIAL(debug) << __func__ << " : "
                              << "wrote account_tx";
-    auto start = std::chrono::system_clock::now();
-
-    bool success = backend_->finishWrites(lgrInfo.seq);
-
-    auto end = std::chrono::system_clock::now();
-
-    auto duration = ((end - start).count()) / 1000000000.0;
-    BOOST_LOG_TRIVIAL(debug)
-        << __func__ << " finished writes. took " << std::to_string(duration);
 
     BOOST_LOG_TRIVIAL(debug)
         << __func__ << " : "
         << "Finished ledger update. " << detail::toString(lgrInfo);
-    return {lgrInfo, success};
+    return result;
 }
 
 // Database must be populated when this starts
@@ -688,12 +804,26 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
         });
     }
 
+    // A ledger whose writes have all been issued, waiting to be committed
+    struct PendingCommit
+    {
+        BuiltLedger ledger;
+        std::size_t numTxns;
+        std::size_t numObjects;
+        std::chrono::time_point<std::chrono::system_clock> start;
+    };
+    // The transformer moves on to the next ledger as soon as it has issued
+    // the writes of the current one, so writes of later ledgers stream while
+    // the committer waits for and commits earlier ones. The size of this
+    // queue bounds how far the transformer can get ahead of the committer
+    ThreadSafeQueue<std::optional<PendingCommit>> commitQueue{
+        maxUncommittedLedgers_};
+
     std::thread transformer{[this,
-                             &minSequence,
                              &writeConflict,
                              &startSequence,
                              &getNext,
-                             &lastPublishedSequence]() {
+                             &commitQueue]() {
         beast::setCurrentThreadName("rippled: ReportingETL transform");
         uint32_t currentSequence = startSequence;
 
@@ -711,32 +841,96 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
             if (isStopping())
                 continue;
 
-            auto numTxns =
+            std::size_t numTxns =
                 fetchResponse->transactions_list().transactions_size();
-            auto numObjects = fetchResponse->ledger_objects().objects_size();
+            std::size_t numObjects =
+                fetchResponse->ledger_objects().objects_size();
             auto start = std::chrono::system_clock::now();
-            auto [lgrInfo, success] = buildNextLedger(*fetchResponse);
+            auto ledger = buildNextLedger(*fetchResponse);
+            auto const& lgrInfo = ledger.lgrInfo;
             auto end = std::chrono::system_clock::now();
 
             auto duration = ((end - start).count()) / 1000000000.0;
+            BOOST_LOG_TRIVIAL(info)
+                << "Transform phase of etl : "
+                << "Issued writes for ledger. Ledger info: "
+                << detail::toString(lgrInfo) << ". txn count = " << numTxns
+                << ". object count = " << numObjects
+                << ". transform time = " << duration
+                << ". transform txns per second per transform thread = "
+                << numTxns / duration / transformThreads_;
+
+            commitQueue.push(
+                PendingCommit{std::move(ledger), numTxns, numObjects, start});
+        }
+        // empty optional tells the committer to shut down
+        commitQueue.push({});
+    }};
+
+    std::thread committer{[this,
+                           &minSequence,
+                           &writeConflict,
+                           &lastPublishedSequence,
+                           &commitQueue]() {
+        beast::setCurrentThreadName("rippled: ReportingETL commit");
+
+        // fees as of the last committed ledger, once known. Ledgers are
+        // committed in order, so this only changes when a ledger changes them
+        std::optional<ripple::Fees> fees;
+        while (true)
+        {
+            std::optional<PendingCommit> pending = commitQueue.pop();
+            if (!pending)
+                break;
+            // after a write conflict, keep draining so the transformer is
+            // not blocked, but don't commit anything else
+            if (writeConflict)
+                continue;
+
+            auto& ledger = pending->ledger;
+            auto const& lgrInfo = ledger.lgrInfo;
+            // waits only for the writes of this and earlier ledgers. Ledgers
+            // are committed one at a time, in order, and a ledger that another
+            // writer already committed is detected as a write conflict
+            bool success = backend_->finishWrites(lgrInfo.seq);
+            auto end = std::chrono::system_clock::now();
+
+            auto duration = ((end - pending->start).count()) / 1000000000.0;
             if (success)
                 BOOST_LOG_TRIVIAL(info)
                     << "Load phase of etl : "
                     << "Successfully wrote ledger! Ledger info: "
-                    << detail::toString(lgrInfo) << ". txn count = " << numTxns
-                    << ". object count = " << numObjects
+                    << detail::toString(lgrInfo)
+                    << ". txn count = " << pending->numTxns
+                    << ". object count = " << pending->numObjects
                     << ". load time = " << duration
-                    << ". load txns per second = " << numTxns / duration
-                    << ". load objs per second = " << numObjects / duration;
+                    << ". load txns per second = "
+                    << pending->numTxns / duration
+                    << ". load objs per second = "
+                    << pending->numObjects / duration;
             else
                 BOOST_LOG_TRIVIAL(error)
                     << "Error writing ledger. " << detail::toString(lgrInfo);
             // success is false if the ledger was already written
             if (success)
             {
-                boost::asio::post(publishStrand_, [this, lgrInfo = lgrInfo]() {
-                    publishLedger(lgrInfo);
-                });
+                if (ledger.fees)
+                    fees = ledger.fees;
+                else if (!fees)
+                    fees = Backend::synchronousAndRetryOnTimeout(
+                        [&](auto yield) {
+                            return backend_->fetchFees(lgrInfo.seq, yield);
+                        });
+                // the publisher uses the transactions and fees built by this
+                // node instead of reading them back from the database
+                boost::asio::post(
+                    publishStrand_,
+                    [this,
+                     lgrInfo = lgrInfo,
+                     transactions = std::move(ledger.transactions),
+                     fees = fees]() mutable {
+                        publishLedger(lgrInfo, std::move(transactions), fees);
+                    });
 
                 lastPublishedSequence = lgrInfo.seq;
             }
@@ -765,6 +959,7 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
     }};
 
     transformer.join();
+    committer.join();
     for (size_t i = 0; i < numExtractors; ++i)
     {
         // pop from each queue that might be blocked on a push
@@ -785,6 +980,146 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
     return lastPublishedSequence;
 }
 
+std::optional<uint32_t>
+ReportingETL::runBackfill(uint32_t startSequence, uint32_t finishSequence)
+{
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " : "
+        << "Starting backfill of ledgers " << startSequence << " - "
+        << finishSequence;
+    writing_ = true;
+
+    // Chunks written by an earlier backfill that was interrupted before the
+    // ledger range caught up with them
+    std::vector<Backend::LedgerRange> written =
+        Backend::synchronousAndRetryOnTimeout([&](auto yield) {
+            return backend_->fetchBackfillProgress(yield);
+        });
+    auto isWritten = [&written](Backend::LedgerRange const& chunk) {
+        return std::any_of(
+            written.begin(), written.end(), [&chunk](auto const& r) {
+                return r.minSequence <= chunk.minSequence &&
+                    r.maxSequence >= chunk.maxSequence;
+            });
+    };
+
+    std::vector<Backend::LedgerRange> chunks;
+    for (uint64_t seq = startSequence; seq <= finishSequence;
+         seq += backfillChunkSize_)
+    {
+        chunks.push_back(
+            {static_cast<uint32_t>(seq),
+             static_cast<uint32_t>(std::min<uint64_t>(
+                 seq + backfillChunkSize_ - 1, finishSequence))});
+    }
+
+    // Workers take chunks in increasing order, but finish them in any order.
+    // The ledger range is only advanced over a contiguous prefix of finished
+    // chunks, so the database never claims a ledger that isn't fully written
+    std::vector<bool> alreadyWritten(chunks.size(), false);
+    for (std::size_t i = 0; i < chunks.size(); ++i)
+        alreadyWritten[i] = isWritten(chunks[i]);
+    // guarded by commitMtx
+    std::vector<bool> chunkDone = alreadyWritten;
+    std::size_t numCommitted = 0;
+    uint32_t committedSequence = startSequence - 1;
+    std::mutex commitMtx;
+    std::atomic_bool writeConflict = false;
+    std::atomic_size_t nextChunk = 0;
+    std::atomic_size_t ledgersWritten = 0;
+
+    // advances the ledger range over every finished chunk at the front.
+    // commitMtx must be held
+    auto commitFinishedChunks = [&]() {
+        std::size_t end = numCommitted;
+        while (end < chunks.size() && chunkDone[end])
+            ++end;
+        if (end == numCommitted || writeConflict)
+            return;
+        uint32_t maxSequence = chunks[end - 1].maxSequence;
+        if (!backend_->advanceRange(maxSequence, committedSequence))
+        {
+            BOOST_LOG_TRIVIAL(error)
+                << __func__ << " : "
+                << "Failed to advance ledger range to " << maxSequence
+                << ". Another process is writing. Stopping backfill";
+            writeConflict = true;
+            return;
+        }
+        numCommitted = end;
+        committedSequence = maxSequence;
+    };
+
+    {
+        std::lock_guard lck(commitMtx);
+        commitFinishedChunks();
+    }
+
+    auto begin = std::chrono::system_clock::now();
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < backfillWorkers_; ++i)
+    {
+        workers.emplace_back([&]() {
+            beast::setCurrentThreadName("rippled: ReportingETL backfill");
+            while (!writeConflict && !isStopping())
+            {
+                std::size_t idx = nextChunk++;
+                if (idx >= chunks.size())
+                    return;
+                if (alreadyWritten[idx])
+                    continue;
+                auto const chunk = chunks[idx];
+                auto start = std::chrono::system_clock::now();
+                for (uint32_t seq = chunk.minSequence;
+                     seq <= chunk.maxSequence;
+                     ++seq)
+                {
+                    if (writeConflict || isStopping())
+                        return;
+                    // neighbors are always requested, since successors can't
+                    // be computed from the cache out of order
+                    auto response = loadBalancer_->fetchLedger(seq, true, true);
+                    if (!response)
+                        return;
+                    buildNextLedger(*response, true);
+                }
+                backend_->syncLedgers(chunk.minSequence, chunk.maxSequence);
+                backend_->writeBackfillProgress(chunk);
+
+                auto end = std::chrono::system_clock::now();
+                auto duration = ((end - start).count()) / 1000000000.0;
+                auto numLedgers = chunk.maxSequence - chunk.minSequence + 1;
+                ledgersWritten += numLedgers;
+                BOOST_LOG_TRIVIAL(info)
+                    << __func__ << " : "
+                    << "Backfilled ledgers " << chunk.minSequence << " - "
+                    << chunk.maxSequence << ". took " << duration
+                    << ". ledgers per second = " << numLedgers / duration;
+
+                std::lock_guard lck(commitMtx);
+                chunkDone[idx] = true;
+                commitFinishedChunks();
+            }
+        });
+    }
+    for (auto& t : workers)
+        t.join();
+
+    auto end = std::chrono::system_clock::now();
+    auto duration = ((end - begin).count()) / 1000000000.0;
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " : "
+        << "Finished backfill. Wrote " << ledgersWritten << " ledgers in "
+        << duration << " seconds. ledgers per second = "
+        << ledgersWritten / duration
+        << ". ledger range now ends at " << committedSequence;
+    writing_ = false;
+
+    if (committedSequence < startSequence)
+        return {};
+    return committedSequence;
+}
+
 // main loop. The software begins monitoring the ledgers that are validated
 // by the nework. The member networkValidatedLedgers_ keeps track of the
 // sequences of ledgers validated by the network. Whenever a ledger is validated
@@ -858,6 +1193,19 @@ ReportingETL::monitor()
         BOOST_LOG_TRIVIAL(info)
             << __func__ << " : "
             << "Database already populated. Picking up from the tip of history";
+        // If far behind, backfill before loading the cache, since backfilled
+        // ledgers are written out of order and bypass the cache
+        if (backfillWorkers_ > 0)
+        {
+            std::optional<uint32_t> target = finishSequence_;
+            if (!target)
+                target = networkValidatedLedgers_->getMostRecent();
+            if (target && *target >= rng->maxSequence + backfillMinLedgers_)
+            {
+                if (runBackfill(rng->maxSequence + 1, *target))
+                    rng = backend_->hardFetchLedgerRangeNoThrow();
+            }
+        }
         loadCache(rng->maxSequence);
     }
     assert(rng);
@@ -1052,9 +1400,11 @@ ReportingETL::loadCacheFromClioPeer(
                         << __func__ << " failed to parse object id";
                     return false;
                 }
+                std::vector<unsigned char> data;
                 boost::algorithm::unhex(
                     obj.at("data").as_string().c_str(),
-                    std::back_inserter(stateObject.blob));
+                    std::back_inserter(data));
+                stateObject.blob = std::move(data);
                 objects.push_back(std::move(stateObject));
             }
             backend_->cache().update(objects, ledgerIndex, true);
@@ -1337,6 +1687,32 @@ ReportingETL::ReportingETL(
     }
     if (config.contains("extractor_threads"))
         extractorThreads_ = config.at("extractor_threads").as_int64();
+    if (config.contains("transform_threads"))
+        transformThreads_ = config.at("transform_threads").as_int64();
+    if (transformThreads_ == 0)
+        throw std::runtime_error("transform_threads must be at least 1");
+    // the thread running buildNextLedger does a share of the transform work,
+    // so the pool only needs the remaining threads
+    if (transformThreads_ > 1)
+        transformPool_ =
+            std::make_unique<boost::asio::thread_pool>(transformThreads_ - 1);
+    if (config.contains("max_uncommitted_ledgers"))
+        maxUncommittedLedgers_ =
+            config.at("max_uncommitted_ledgers").as_int64();
+    if (config.contains("backfill"))
+    {
+        auto backfill = config.at("backfill").as_object();
+        if (backfill.contains("workers") && backfill.at("workers").is_int64())
+            backfillWorkers_ = backfill.at("workers").as_int64();
+        if (backfill.contains("chunk_size") &&
+            backfill.at("chunk_size").is_int64())
+            backfillChunkSize_ = backfill.at("chunk_size").as_int64();
+        if (backfill.contains("min_ledgers") &&
+            backfill.at("min_ledgers").is_int64())
+            backfillMinLedgers_ = backfill.at("min_ledgers").as_int64();
+        if (backfillChunkSize_ == 0)
+            throw std::runtime_error("backfill chunk_size must be positive");
+    }
     if (config.contains("txn_threshold"))
         txnThreshold_ = config.at("txn_threshold").as_int64();
     if (config.contains("cache"))
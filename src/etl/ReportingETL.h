@@ -3,6 +3,7 @@
 
 #include <ripple/ledger/ReadView.h>
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/core/string.hpp>
 #include <boost/beast/websocket.hpp>
@@ -34,6 +35,19 @@ struct FormattedTransactionsData
     std::vector<AccountTransactionsData> accountTxData;
     std::vector<NFTTransactionsData> nfTokenTxData;
     std::vector<NFTsData> nfTokensData;
+    // the transactions and their metadata, in ledger order. Only kept when
+    // the ledger is going to be published
+    std::vector<Backend::TransactionAndMetadata> transactions;
+};
+
+/// A ledger built by the ETL, along with what is needed to publish it, so
+/// that the publisher doesn't read the ledger back from the database
+struct BuiltLedger
+{
+    ripple::LedgerInfo lgrInfo;
+    std::vector<Backend::TransactionAndMetadata> transactions;
+    // set if the fee settings changed in this ledger
+    std::optional<ripple::Fees> fees;
 };
 class SubscriptionManager;
 
@@ -60,6 +74,24 @@ private:
     std::shared_ptr<ETLLoadBalancer> loadBalancer_;
     std::optional<std::uint32_t> onlineDeleteInterval_;
     std::uint32_t extractorThreads_ = 1;
+    /// Number of threads used to deserialize, extract and write the
+    /// transactions of a ledger. The thread building the ledger is one of
+    /// them, so a value of 1 transforms everything on that thread
+    std::uint32_t transformThreads_ = 1;
+    /// Ledgers with fewer transactions than this per thread are not worth
+    /// splitting up
+    std::uint32_t minTxnsPerTransformChunk_ = 16;
+    std::unique_ptr<boost::asio::thread_pool> transformPool_;
+    /// Number of threads used to backfill history on startup, when the
+    /// database is at least backfillMinLedgers_ behind. 0 disables backfill
+    std::uint32_t backfillWorkers_ = 0;
+    /// Number of consecutive ledgers a backfill worker writes before
+    /// checkpointing them
+    std::uint32_t backfillChunkSize_ = 256;
+    std::uint32_t backfillMinLedgers_ = 1024;
+    /// Number of ledgers whose writes may be issued while waiting for an
+    /// earlier ledger to be committed
+    std::uint32_t maxUncommittedLedgers_ = 4;
 
     enum class CacheLoadStyle { ASYNC, SYNC, NOT_AT_ALL };
 
@@ -204,6 +236,18 @@ private:
     std::optional<uint32_t>
     runETLPipeline(uint32_t startSequence, int offset);
 
+    /// Write the ledgers in [startSequence, finishSequence] out of order, on
+    /// several threads, in chunks of backfillChunkSize_ ledgers. Finished
+    /// chunks are checkpointed in the database, and the ledger range is only
+    /// advanced once every chunk before it is finished, so an interrupted
+    /// backfill resumes where it left off.
+    /// @note startSequence must directly follow the most recent ledger in
+    /// the database, and the cache must not be loaded yet
+    /// @return the most recent ledger in the database afterwards, if the
+    /// range was advanced
+    std::optional<uint32_t>
+    runBackfill(uint32_t startSequence, uint32_t finishSequence);
+
     /// Monitor the network for newly validated ledgers. Also monitor the
     /// database to see if any process is writing those ledgers. This function
     /// is called when the application starts, and will only return when the
@@ -243,9 +287,13 @@ private:
 
     /// Insert all of the extracted transactions into the ledger, returning
     /// transactions related to accounts, transactions related to NFTs, and
-    /// NFTs themselves for later processsing.
+    /// NFTs themselves for later processsing. The transactions are split into
+    /// contiguous chunks that are transformed on transformThreads_ threads;
+    /// the results are concatenated in transaction order.
     /// @param ledger ledger to insert transactions into
     /// @param data data extracted from an ETL source
+    /// @param keepTransactions whether to also return a copy of the
+    /// transactions and their metadata
     /// @return struct that contains the neccessary info to write to the
     /// account_transactions/account_tx and nft_token_transactions tables
     /// (mostly transaction hashes, corresponding nodestore hashes and affected
@@ -253,7 +301,8 @@ private:
     FormattedTransactionsData
     insertTransactions(
         ripple::LedgerInfo const& ledger,
-        org::xrpl::rpc::v1::GetLedgerResponse& data);
+        org::xrpl::rpc::v1::GetLedgerResponse& data,
+        bool keepTransactions = false);
 
     // TODO update this documentation
     /// Build the next ledger using the previous ledger and the extracted data.
@@ -262,9 +311,15 @@ private:
     /// following parent
     /// @param parent the previous ledger
     /// @param rawData data extracted from an ETL source
-    /// @return the newly built ledger and data to write to the database
-    std::pair<ripple::LedgerInfo, bool>
-    buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData);
+    /// @param isBackfill whether the ledger is written out of order. If so,
+    /// rawData must include object neighbors and the cache is not updated
+    /// @return the newly built ledger. All of its writes have been issued, but
+    /// the ledger is not committed; call finishWrites() to commit it. Unless
+    /// backfilling, the transactions and fees are returned for publishing
+    BuiltLedger
+    buildNextLedger(
+        org::xrpl::rpc::v1::GetLedgerResponse& rawData,
+        bool isBackfill = false);
 
     /// Attempt to read the specified ledger from the database, and then publish
     /// that ledger to the ledgers stream.
@@ -277,8 +332,16 @@ private:
 
     /// Publish the passed in ledger
     /// @param ledger the ledger to publish
+    /// @param transactions transactions of the ledger, if already in memory.
+    /// Read from the database otherwise
+    /// @param fees fees of the ledger, if already known. Read from the
+    /// database otherwise
     void
-    publishLedger(ripple::LedgerInfo const& lgrInfo);
+    publishLedger(
+        ripple::LedgerInfo const& lgrInfo,
+        std::optional<std::vector<Backend::TransactionAndMetadata>>
+            transactions = {},
+        std::optional<ripple::Fees> fees = {});
 
     bool
     isStopping()
@@ -345,6 +408,8 @@ public:
             worker_.join();
         if (cacheDownloader_.joinable())
             cacheDownloader_.join();
+        if (transformPool_)
+            transformPool_->join();
 
         BOOST_LOG_TRIVIAL(debug) << "Joined ReportingETL worker thread";
     }
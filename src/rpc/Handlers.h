@@ -98,6 +98,9 @@ doUnsubscribe(Context const& context);
 Result
 doServerInfo(Context const& context);
 
+Result
+doOnlineDelete(Context const& context);
+
 // Utility methods
 Result
 doRandom(Context const& context);
@@ -277,6 +277,7 @@ static HandlerTable handlerTable{
     {"ledger_range", &doLedgerRange, {}},
     {"subscribe", &doSubscribe, {}},
     {"server_info", &doServerInfo, {}},
+    {"online_delete", &doOnlineDelete, {}, true},
     {"unsubscribe", &doUnsubscribe, {}},
     {"tx", &doTx, {}},
     {"transaction_entry", &doTransactionEntry, {}},
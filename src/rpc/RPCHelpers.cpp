@@ -2,9 +2,12 @@
 #include <boost/format.hpp>
 
 #include <ripple/basics/StringUtilities.h>
+#include <ripple/protocol/TER.h>
+#include <ripple/protocol/TxFormats.h>
 
 #include <backend/BackendInterface.h>
 #include <rpc/RPCHelpers.h>
+#include <subscriptions/SubscriptionManager.h>
 
 namespace RPC {
 
@@ -1148,6 +1151,112 @@ accountFunds(
     }
 }
 
+std::vector<ripple::STAmount>
+accountFundsBatch(
+    BackendInterface const& backend,
+    std::uint32_t sequence,
+    std::vector<std::pair<ripple::STAmount, ripple::AccountID>> const&
+        requests,
+    boost::asio::yield_context& yield)
+{
+    // the account roots of XRP holders and the fees for their reserves, and
+    // the trust lines of IOU holders and the account roots of their issuers
+    std::vector<ripple::uint256> keys;
+    for (auto const& [amount, id] : requests)
+    {
+        if (amount.native())
+        {
+            keys.push_back(ripple::keylet::account(id).key);
+            keys.push_back(ripple::keylet::fees().key);
+        }
+        else if (amount.getIssuer() != id)
+        {
+            keys.push_back(ripple::keylet::line(
+                                id, amount.getIssuer(), amount.getCurrency())
+                               .key);
+            keys.push_back(ripple::keylet::account(amount.getIssuer()).key);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    auto blobs = backend.fetchLedgerObjects(keys, sequence, yield);
+    auto blob = [&](ripple::uint256 const& key) -> auto const& {
+        return blobs[std::lower_bound(keys.begin(), keys.end(), key) -
+                     keys.begin()];
+    };
+    auto read = [&](ripple::uint256 const& key)
+        -> std::optional<ripple::SLE> {
+        auto const& object = blob(key);
+        if (object.size() == 0)
+            return {};
+        ripple::SerialIter it{object.data(), object.size()};
+        return ripple::SLE{it, key};
+    };
+
+    std::optional<ripple::Fees> fees;
+    std::vector<ripple::STAmount> funds;
+    funds.reserve(requests.size());
+    for (auto const& [amount, id] : requests)
+    {
+        if (!amount.native() && amount.getIssuer() == id)
+        {
+            funds.push_back(amount);
+        }
+        else if (amount.native())
+        {
+            // same as xrpLiquid
+            auto root = read(ripple::keylet::account(id).key);
+            if (!root)
+            {
+                funds.emplace_back(ripple::XRPAmount{beast::zero});
+                continue;
+            }
+            if (!fees)
+                fees = deserializeFees(blob(ripple::keylet::fees().key));
+
+            auto const reserve = fees->accountReserve(
+                root->getFieldU32(ripple::sfOwnerCount));
+            auto const balance = root->getFieldAmount(ripple::sfBalance);
+
+            ripple::STAmount liquid = balance - reserve;
+            if (balance < reserve)
+                liquid.clear();
+            funds.emplace_back(liquid.xrp());
+        }
+        else
+        {
+            // same as accountHolds, with zeroIfFrozen
+            auto const issue = amount.issue();
+            auto line = read(
+                ripple::keylet::line(id, issue.account, issue.currency).key);
+            auto issuer = read(ripple::keylet::account(issue.account).key);
+
+            auto frozen = issuer &&
+                (issuer->isFlag(ripple::lsfGlobalFreeze) ||
+                 (line &&
+                  line->isFlag(
+                      issue.account > id ? ripple::lsfHighFreeze
+                                         : ripple::lsfLowFreeze)));
+
+            ripple::STAmount held;
+            if (!line || frozen)
+            {
+                held.clear(issue);
+            }
+            else
+            {
+                held = line->getFieldAmount(ripple::sfBalance);
+                if (id > issue.account)
+                    held.negate();
+                held.setIssuer(issue.account);
+            }
+            funds.push_back(held);
+        }
+    }
+    return funds;
+}
+
 ripple::STAmount
 accountHolds(
     BackendInterface const& backend,
@@ -1463,6 +1572,112 @@ parseBook(boost::json::object const& request)
     return ripple::Book{{pay_currency, pay_issuer}, {get_currency, get_issuer}};
 }
 
+std::variant<Status, TransactionFilter>
+parseTransactionFilter(boost::json::object const& request)
+{
+    if (!request.at("filter").is_object())
+        return Status{Error::rpcINVALID_PARAMS, "filterNotObject"};
+
+    auto const& filter = request.at("filter").as_object();
+    TransactionFilter parsed;
+
+    if (filter.contains("transaction_types"))
+    {
+        if (!filter.at("transaction_types").is_array())
+            return Status{Error::rpcINVALID_PARAMS, "transactionTypesNotArray"};
+
+        for (auto const& type : filter.at("transaction_types").as_array())
+        {
+            if (!type.is_string())
+                return Status{
+                    Error::rpcINVALID_PARAMS, "transactionTypeNotString"};
+
+            std::string s = type.as_string().c_str();
+            try
+            {
+                parsed.types.push_back(
+                    ripple::TxFormats::getInstance().findTypeByName(s));
+            }
+            catch (std::exception const& e)
+            {
+                return Status{
+                    Error::rpcINVALID_PARAMS, "invalidTransactionType"};
+            }
+        }
+    }
+
+    if (filter.contains("engine_results"))
+    {
+        if (!filter.at("engine_results").is_array())
+            return Status{Error::rpcINVALID_PARAMS, "engineResultsNotArray"};
+
+        for (auto const& result : filter.at("engine_results").as_array())
+        {
+            if (!result.is_string())
+                return Status{
+                    Error::rpcINVALID_PARAMS, "engineResultNotString"};
+
+            std::string s = result.as_string().c_str();
+            auto ter = ripple::transCode(s);
+            if (!ter)
+                return Status{
+                    Error::rpcINVALID_PARAMS, "invalidEngineResult"};
+
+            parsed.results.push_back(ripple::TERtoInt(*ter));
+        }
+    }
+
+    if (filter.contains("min_xrp_drops"))
+    {
+        auto const& drops = filter.at("min_xrp_drops");
+        if (!drops.is_int64() || drops.as_int64() < 0)
+            return Status{Error::rpcINVALID_PARAMS, "minXRPDropsMalformed"};
+
+        parsed.minXRPDrops = drops.as_int64();
+    }
+
+    if (filter.contains("currencies"))
+    {
+        if (!filter.at("currencies").is_array())
+            return Status{Error::rpcINVALID_PARAMS, "currenciesNotArray"};
+
+        for (auto const& entry : filter.at("currencies").as_array())
+        {
+            if (!entry.is_object())
+                return Status{Error::rpcINVALID_PARAMS, "currencyNotObject"};
+
+            auto const& issue = entry.as_object();
+            if (!issue.contains("currency") ||
+                !issue.at("currency").is_string())
+                return Status{Error::rpcINVALID_PARAMS, "currencyNotString"};
+
+            ripple::Currency currency;
+            if (!ripple::to_currency(
+                    currency, issue.at("currency").as_string().c_str()))
+                return Status{Error::rpcINVALID_PARAMS, "malformedCurrency"};
+
+            if (!issue.contains("issuer"))
+            {
+                parsed.currencies.push_back(currency);
+                continue;
+            }
+
+            if (!issue.at("issuer").is_string())
+                return Status{Error::rpcINVALID_PARAMS, "issuerNotString"};
+
+            ripple::AccountID issuer;
+            if (!ripple::to_issuer(
+                    issuer, issue.at("issuer").as_string().c_str()) ||
+                ripple::isXRP(currency) != ripple::isXRP(issuer))
+                return Status{Error::rpcINVALID_PARAMS, "malformedIssuer"};
+
+            parsed.issues.push_back({currency, issuer});
+        }
+    }
+
+    return parsed;
+}
+
 std::variant<Status, ripple::AccountID>
 parseTaker(boost::json::value const& taker)
 {
@@ -21,6 +21,8 @@
 // Access (SF)ield name (S)trings
 #define SFS(x) ripple::x.jsonName.c_str()
 
+struct TransactionFilter;
+
 namespace RPC {
 std::optional<ripple::AccountID>
 accountFromStringStrict(std::string const& account);
@@ -153,6 +155,16 @@ accountFunds(
     ripple::AccountID const& id,
     boost::asio::yield_context& yield);
 
+// accountFunds of many (amount, account) pairs at once. All of the ledger
+// objects needed are fetched with a single fetchLedgerObjects call
+std::vector<ripple::STAmount>
+accountFundsBatch(
+    BackendInterface const& backend,
+    std::uint32_t sequence,
+    std::vector<std::pair<ripple::STAmount, ripple::AccountID>> const&
+        requests,
+    boost::asio::yield_context& yield);
+
 ripple::STAmount
 accountHolds(
     BackendInterface const& backend,
@@ -189,6 +201,11 @@ postProcessOrderBook(
 std::variant<Status, ripple::Book>
 parseBook(boost::json::object const& request);
 
+/// Parse the filter of a subscription to the transactions stream, the
+/// "filter" member of request
+std::variant<Status, TransactionFilter>
+parseTransactionFilter(boost::json::object const& request);
+
 std::variant<Status, ripple::AccountID>
 parseTaker(boost::json::value const& request);
 
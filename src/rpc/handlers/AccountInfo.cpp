@@ -54,7 +54,7 @@ doAccountInfo(Context const& context)
 
     auto key = ripple::keylet::account(accountID.value());
 
-    std::optional<std::vector<unsigned char>> dbResponse =
+    std::optional<Backend::Blob> dbResponse =
         context.backend->fetchLedgerObject(key.key, lgrInfo.seq, context.yield);
 
     if (!dbResponse)
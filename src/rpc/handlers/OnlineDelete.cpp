@@ -0,0 +1,37 @@
+#include <backend/BackendInterface.h>
+#include <rpc/RPCHelpers.h>
+
+namespace RPC {
+
+Result
+doOnlineDelete(Context const& context)
+{
+    if (context.clientIp != "127.0.0.1")
+        return Status{Error::rpcNO_PERMISSION};
+
+    auto const status = context.backend->getOnlineDeleteStatus();
+
+    boost::json::object response = {};
+    response["running"] = status.running;
+    if (status.minLedger == 0)
+        return response;
+
+    response["min_ledger"] = status.minLedger;
+    response["num_ranges"] = status.numRanges;
+    response["ranges_done"] = status.rangesDone;
+    response["objects_written"] = status.objectsWritten;
+    response["bytes_written"] = status.bytesWritten;
+
+    auto const end = status.running ? std::chrono::system_clock::now()
+                                    : status.endTime;
+    auto const elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                             end - status.startTime)
+                             .count();
+    response["elapsed_seconds"] = elapsed;
+    if (elapsed > 0)
+        response["bytes_per_second"] = status.bytesWritten / elapsed;
+
+    return response;
+}
+
+}  // namespace RPC
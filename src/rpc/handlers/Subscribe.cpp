@@ -39,7 +39,9 @@ subscribeToStreams(
     boost::asio::yield_context& yield,
     boost::json::object const& request,
     std::shared_ptr<WsBase> session,
-    SubscriptionManager& manager)
+    SubscriptionManager& manager,
+    bool binary,
+    std::optional<TransactionFilter> const& filter)
 {
     boost::json::array const& streams = request.at(JS(streams)).as_array();
 
@@ -50,8 +52,10 @@ subscribeToStreams(
 
         if (s == "ledger")
             response = manager.subLedger(yield, session);
+        else if (s == "transactions" && filter)
+            manager.subFilteredTransactions(session, *filter, binary);
         else if (s == "transactions")
-            manager.subTransactions(session);
+            manager.subTransactions(session, binary);
         else if (s == "transactions_proposed")
             manager.subProposedTransactions(session);
         else if (s == "validations")
@@ -117,7 +121,8 @@ void
 subscribeToAccounts(
     boost::json::object const& request,
     std::shared_ptr<WsBase> session,
-    SubscriptionManager& manager)
+    SubscriptionManager& manager,
+    bool binary)
 {
     boost::json::array const& accounts = request.at(JS(accounts)).as_array();
 
@@ -133,7 +138,7 @@ subscribeToAccounts(
             continue;
         }
 
-        manager.subAccount(*accountID, session);
+        manager.subAccount(*accountID, session, binary);
     }
 }
 
@@ -272,11 +277,12 @@ void
 subscribeToBooks(
     std::vector<ripple::Book> const& books,
     std::shared_ptr<WsBase> session,
-    SubscriptionManager& manager)
+    SubscriptionManager& manager,
+    bool binary)
 {
     for (auto const& book : books)
     {
-        manager.subBook(book, session);
+        manager.subBook(book, session, binary);
     }
 }
 
@@ -339,6 +345,53 @@ doSubscribe(Context const& context)
             return status;
     }
 
+    // transactions are published as tx_blob and meta hex instead of JSON
+    bool binary = false;
+    if (request.contains(JS(binary)))
+    {
+        if (!request.at(JS(binary)).is_bool())
+            return Status{Error::rpcINVALID_PARAMS, "binaryFlagNotBool"};
+
+        binary = request.at(JS(binary)).as_bool();
+    }
+
+    // the ledger, transactions and book_changes streams are first sent what
+    // was published from this ledger on, if the server still holds all of it
+    std::optional<std::uint32_t> resumeFrom;
+    if (request.contains("resume_from"))
+    {
+        auto const& resume = request.at("resume_from");
+        if (!resume.is_int64() || resume.as_int64() < 0 ||
+            resume.as_int64() > std::numeric_limits<std::uint32_t>::max())
+            return Status{Error::rpcINVALID_PARAMS, "resumeFromMalformed"};
+
+        resumeFrom = resume.as_int64();
+    }
+
+    // only the transactions that pass the filter are sent on the
+    // transactions stream. The history is not filtered, so a filtered
+    // subscription can not be resumed
+    std::optional<TransactionFilter> filter;
+    if (request.contains("filter"))
+    {
+        auto const streams = request.contains(JS(streams))
+            ? request.at(JS(streams)).as_array()
+            : boost::json::array{};
+        if (std::find(streams.begin(), streams.end(), "transactions") ==
+            streams.end())
+            return Status{
+                Error::rpcINVALID_PARAMS, "filterWithoutTransactionsStream"};
+
+        if (resumeFrom)
+            return Status{Error::rpcINVALID_PARAMS, "filterCannotResume"};
+
+        auto parsed = parseTransactionFilter(request);
+        if (auto status = std::get_if<Status>(&parsed))
+            return *status;
+
+        filter = std::get<TransactionFilter>(parsed);
+    }
+
     std::vector<ripple::Book> books;
     boost::json::array snapshot;
     if (request.contains(JS(books)))
@@ -354,20 +407,42 @@ doSubscribe(Context const& context)
         snapshot = std::move(snap);
     }
 
+    // the history is checked and replayed at once, after everything else is
+    // validated, so that a failed resume leaves the session subscribed to
+    // nothing new. The streams it resumed are then subscribed to again below,
+    // which does nothing
+    if (resumeFrom && request.contains(JS(streams)))
+    {
+        std::vector<std::string> streams;
+        for (auto const& stream : request.at(JS(streams)).as_array())
+            streams.push_back(stream.as_string().c_str());
+
+        if (!context.subscriptions->resumeStreams(
+                context.session, streams, binary, *resumeFrom))
+            return Status{Error::rpcLGR_NOT_FOUND, "resumeLedgerNotInHistory"};
+    }
+
     boost::json::object response;
     if (request.contains(JS(streams)))
         response = subscribeToStreams(
-            context.yield, request, context.session, *context.subscriptions);
+            context.yield,
+            request,
+            context.session,
+            *context.subscriptions,
+            binary,
+            filter);
 
     if (request.contains(JS(accounts)))
-        subscribeToAccounts(request, context.session, *context.subscriptions);
+        subscribeToAccounts(
+            request, context.session, *context.subscriptions, binary);
 
     if (request.contains(JS(accounts_proposed)))
         subscribeToAccountsProposed(
             request, context.session, *context.subscriptions);
 
     if (request.contains(JS(books)))
-        subscribeToBooks(books, context.session, *context.subscriptions);
+        subscribeToBooks(
+            books, context.session, *context.subscriptions, binary);
 
     if (snapshot.size())
         response[JS(offers)] = snapshot;
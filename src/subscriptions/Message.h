@@ -8,6 +8,7 @@
 class Message
 {
     std::string message_;
+    std::string stream_;
 
 public:
     Message() = delete;
@@ -15,6 +16,13 @@ public:
     {
     }
 
+    // A message published to a stream. Sessions that can't keep up may drop
+    // these, but never the messages that are not part of a stream
+    Message(std::string&& message, std::string const& stream)
+        : message_(std::move(message)), stream_(stream)
+    {
+    }
+
     Message(Message const&) = delete;
     Message(Message&&) = delete;
     Message&
@@ -35,6 +43,12 @@ public:
     {
         return message_.size();
     }
+
+    std::string const&
+    stream() const
+    {
+        return stream_;
+    }
 };
 
 #endif  // CLIO_SUBSCRIPTION_MESSAGE_H
\ No newline at end of file
@@ -81,10 +81,18 @@ template <class Key>
 void
 SubscriptionMap<Key>::subscribe(
     std::shared_ptr<WsBase> const& session,
-    Key const& account)
+    Key const& key)
 {
-    boost::asio::post(strand_, [this, session, account]() {
-        addSession(session, subscribers_[account], subCount_);
+    auto const index = shardIndex(session);
+    auto& shard = *shards_[index];
+    boost::asio::post(shard.strand, [this, &shard, index, session, key]() {
+        auto& subscribers = shard.sessions[key];
+        if (subscribers.empty())
+        {
+            std::lock_guard lck{keysMtx_};
+            keyShards_[key].insert(index);
+        }
+        addSession(session, subscribers, subCount_);
     });
 }
 
@@ -92,23 +100,19 @@ template <class Key>
 void
 SubscriptionMap<Key>::unsubscribe(
     std::shared_ptr<WsBase> const& session,
-    Key const& account)
+    Key const& key)
 {
-    boost::asio::post(strand_, [this, account, session]() {
-        if (!subscribers_.contains(account))
-            return;
-
-        if (!subscribers_[account].contains(session))
+    auto const index = shardIndex(session);
+    auto& shard = *shards_[index];
+    boost::asio::post(shard.strand, [this, &shard, index, session, key]() {
+        auto it = shard.sessions.find(key);
+        if (it == shard.sessions.end())
             return;
 
-        --subCount_;
+        removeSession(session, it->second, subCount_);
 
-        subscribers_[account].erase(session);
-
-        if (subscribers_[account].size() == 0)
-        {
-            subscribers_.erase(account);
-        }
+        if (it->second.empty())
+            removeKey(index, key);
     });
 }
 
@@ -116,14 +120,229 @@ template <class Key>
 void
 SubscriptionMap<Key>::publish(
     std::shared_ptr<Message>& message,
-    Key const& account)
+    Key const& key)
 {
-    boost::asio::post(strand_, [this, account, message]() {
-        if (!subscribers_.contains(account))
-            return;
+    // posting from a single thread keeps the order of the messages on each
+    // strand, so each session gets them in the order they are published
+    std::lock_guard lck{keysMtx_};
+    auto shards = keyShards_.find(key);
+    if (shards == keyShards_.end())
+        return;
 
-        sendToSubscribers(message, subscribers_[account], subCount_);
-    });
+    for (auto const index : shards->second)
+    {
+        auto& shard = *shards_[index];
+        boost::asio::post(shard.strand, [this, &shard, index, key, message]() {
+            auto it = shard.sessions.find(key);
+            if (it == shard.sessions.end())
+                return;
+
+            sendToSubscribers(message, it->second, subCount_);
+
+            if (it->second.empty())
+                removeKey(index, key);
+        });
+    }
+}
+
+template <class Key>
+void
+SubscriptionMap<Key>::removeKey(std::size_t const index, Key const& key)
+{
+    shards_[index]->sessions.erase(key);
+
+    std::lock_guard lck{keysMtx_};
+    auto shards = keyShards_.find(key);
+    if (shards == keyShards_.end())
+        return;
+
+    shards->second.erase(index);
+    if (shards->second.empty())
+        keyShards_.erase(shards);
+}
+
+template class SubscriptionMap<ripple::AccountID>;
+template class SubscriptionMap<ripple::Book>;
+template class SubscriptionMap<std::string>;
+
+SendQueueLimits
+SendQueueLimits::make_SendQueueLimits(boost::json::object const& config)
+{
+    SendQueueLimits limits;
+    if (!config.contains("subscription_send_queue"))
+        return limits;
+
+    auto const& queue = config.at("subscription_send_queue").as_object();
+    if (queue.contains("max_messages") && queue.at("max_messages").is_int64())
+        limits.maxMessages = queue.at("max_messages").as_int64();
+    if (queue.contains("max_bytes") && queue.at("max_bytes").is_int64())
+        limits.maxBytes = queue.at("max_bytes").as_int64();
+    if (queue.contains("policy"))
+    {
+        auto const& policy = queue.at("policy");
+        if (policy == "drop_oldest")
+            limits.policy = Policy::DROP_OLDEST;
+        else if (policy == "drop_stream")
+            limits.policy = Policy::DROP_STREAM;
+        else if (policy == "disconnect")
+            limits.policy = Policy::DISCONNECT;
+        else
+            throw std::runtime_error(
+                "subscription_send_queue.policy must be \"drop_oldest\", "
+                "\"drop_stream\" or \"disconnect\"");
+    }
+    return limits;
+}
+
+boost::json::object
+SendQueueStats::report() const
+{
+    boost::json::object stats;
+    stats["queued_messages"] = queuedMessages.load();
+    stats["queued_bytes"] = queuedBytes.load();
+    stats["max_queued_messages"] = maxQueuedMessages.load();
+    stats["dropped_messages"] = droppedMessages.load();
+    stats["dropped_streams"] = droppedStreams.load();
+    stats["disconnects"] = disconnects.load();
+    return stats;
+}
+
+bool
+TransactionFilter::matches(TransactionAttributes const& attributes) const
+{
+    auto contains = [](auto const& values, auto const& value) {
+        return std::find(values.begin(), values.end(), value) != values.end();
+    };
+
+    if (!types.empty() && !contains(types, attributes.type))
+        return false;
+
+    if (!results.empty() && !contains(results, attributes.result))
+        return false;
+
+    if (attributes.xrpDrops < minXRPDrops)
+        return false;
+
+    if (issues.empty() && currencies.empty())
+        return true;
+
+    return std::any_of(
+        attributes.issues.begin(),
+        attributes.issues.end(),
+        [&](ripple::Issue const& issue) {
+            return contains(issues, issue) ||
+                contains(currencies, issue.currency);
+        });
+}
+
+std::string
+TransactionFilter::key() const
+{
+    auto join = [](std::vector<std::string> values) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+
+        std::string joined;
+        for (auto const& value : values)
+            joined += value + ",";
+        return joined;
+    };
+
+    std::vector<std::string> typeKeys;
+    for (auto const& type : types)
+        typeKeys.push_back(std::to_string(type));
+
+    std::vector<std::string> resultKeys;
+    for (auto const& result : results)
+        resultKeys.push_back(std::to_string(result));
+
+    std::vector<std::string> issueKeys;
+    for (auto const& issue : issues)
+        issueKeys.push_back(ripple::to_string(issue));
+
+    std::vector<std::string> currencyKeys;
+    for (auto const& currency : currencies)
+        currencyKeys.push_back(ripple::to_string(currency));
+
+    return "types:" + join(typeKeys) + ";results:" + join(resultKeys) +
+        ";min_xrp_drops:" + std::to_string(minXRPDrops) +
+        ";issues:" + join(issueKeys) + ";currencies:" + join(currencyKeys);
+}
+
+void
+PublishHistory::publish(
+    std::string const& stream,
+    std::uint32_t sequence,
+    std::shared_ptr<Message> const& message,
+    Subscription& subscribers)
+{
+    if (!enabled())
+    {
+        subscribers.publish(message);
+        return;
+    }
+
+    std::lock_guard lck{mtx_};
+    if (ledgers_.empty() || ledgers_.back().sequence != sequence)
+    {
+        if (!ledgers_.empty() && ledgers_.back().sequence + 1 != sequence)
+            ledgers_.clear();
+
+        ledgers_.push_back({sequence});
+        if (ledgers_.size() > maxLedgers_)
+            ledgers_.pop_front();
+    }
+    ledgers_.back().streams[stream].push_back(message);
+
+    subscribers.publish(message);
+}
+
+bool
+PublishHistory::containsLocked(std::uint32_t sequence) const
+{
+    return !ledgers_.empty() && sequence >= ledgers_.front().sequence &&
+        sequence <= ledgers_.back().sequence + 1;
+}
+
+bool
+PublishHistory::contains(std::uint32_t sequence)
+{
+    std::lock_guard lck{mtx_};
+    return containsLocked(sequence);
+}
+
+bool
+PublishHistory::resume(
+    std::uint32_t sequence,
+    std::shared_ptr<WsBase> const& session,
+    std::vector<std::pair<std::string, Subscription*>> const& streams)
+{
+    std::lock_guard lck{mtx_};
+    if (!containsLocked(sequence))
+        return false;
+
+    for (auto const& [stream, subscribers] : streams)
+    {
+        std::vector<std::shared_ptr<Message>> messages;
+        for (auto const& ledger : ledgers_)
+        {
+            if (ledger.sequence < sequence)
+                continue;
+
+            auto it = ledger.streams.find(stream);
+            if (it == ledger.streams.end())
+                continue;
+
+            messages.insert(
+                messages.end(), it->second.begin(), it->second.end());
+        }
+        session->sendReplay(std::move(messages));
+
+        // the messages published from now on are posted to the strand of
+        // subscribers after this, so they are all sent live
+        subscribers->subscribe(session);
+    }
+    return true;
 }
 
 boost::json::object
@@ -183,28 +402,88 @@ SubscriptionManager::unsubLedger(std::shared_ptr<WsBase> session)
 }
 
 void
-SubscriptionManager::subTransactions(std::shared_ptr<WsBase> session)
+SubscriptionManager::subTransactions(
+    std::shared_ptr<WsBase> session,
+    bool binary)
 {
-    txSubscribers_.subscribe(session);
+    if (binary)
+        txBinarySubscribers_.subscribe(session);
+    else
+        txSubscribers_.subscribe(session);
 }
 
 void
 SubscriptionManager::unsubTransactions(std::shared_ptr<WsBase> session)
 {
     txSubscribers_.unsubscribe(session);
+    txBinarySubscribers_.unsubscribe(session);
+    unsubFilteredTransactions(session);
+}
+
+void
+SubscriptionManager::subFilteredTransactions(
+    std::shared_ptr<WsBase> session,
+    TransactionFilter const& filter,
+    bool binary)
+{
+    auto key = filter.key();
+    {
+        std::lock_guard lck{filtersMtx_};
+        if (sessionFilters_[session].insert(key).second)
+        {
+            auto& group = filters_.try_emplace(key, FilterGroup{filter})
+                              .first->second;
+            ++group.sessions;
+        }
+    }
+
+    if (binary)
+        filteredBinarySubscribers_.subscribe(session, key);
+    else
+        filteredSubscribers_.subscribe(session, key);
+
+    std::unique_lock lk(cleanupMtx_);
+    cleanupFuncs_[session].emplace_back(
+        "transactions",
+        [this](session_ptr session) { unsubFilteredTransactions(session); });
+}
+
+void
+SubscriptionManager::unsubFilteredTransactions(std::shared_ptr<WsBase> session)
+{
+    std::lock_guard lck{filtersMtx_};
+    auto it = sessionFilters_.find(session);
+    if (it == sessionFilters_.end())
+        return;
+
+    for (auto const& key : it->second)
+    {
+        filteredSubscribers_.unsubscribe(session, key);
+        filteredBinarySubscribers_.unsubscribe(session, key);
+
+        auto group = filters_.find(key);
+        if (group != filters_.end() && --group->second.sessions == 0)
+            filters_.erase(group);
+    }
+    sessionFilters_.erase(it);
 }
 
 void
 SubscriptionManager::subAccount(
     ripple::AccountID const& account,
-    std::shared_ptr<WsBase>& session)
+    std::shared_ptr<WsBase>& session,
+    bool binary)
 {
-    accountSubscribers_.subscribe(session, account);
+    if (binary)
+        accountBinarySubscribers_.subscribe(session, account);
+    else
+        accountSubscribers_.subscribe(session, account);
 
     std::unique_lock lk(cleanupMtx_);
-    cleanupFuncs_[session].emplace_back([this, account](session_ptr session) {
-        unsubAccount(account, session);
-    });
+    cleanupFuncs_[session].emplace_back(
+        "transactions", [this, account](session_ptr session) {
+            unsubAccount(account, session);
+        });
 }
 
 void
@@ -213,17 +492,23 @@ SubscriptionManager::unsubAccount(
     std::shared_ptr<WsBase>& session)
 {
     accountSubscribers_.unsubscribe(session, account);
+    accountBinarySubscribers_.unsubscribe(session, account);
 }
 
 void
 SubscriptionManager::subBook(
     ripple::Book const& book,
-    std::shared_ptr<WsBase> session)
+    std::shared_ptr<WsBase> session,
+    bool binary)
 {
-    bookSubscribers_.subscribe(session, book);
+    if (binary)
+        bookBinarySubscribers_.subscribe(session, book);
+    else
+        bookSubscribers_.subscribe(session, book);
 
     std::unique_lock lk(cleanupMtx_);
     cleanupFuncs_[session].emplace_back(
+        "transactions",
         [this, book](session_ptr session) { unsubBook(book, session); });
 }
 
@@ -233,6 +518,7 @@ SubscriptionManager::unsubBook(
     std::shared_ptr<WsBase> session)
 {
     bookSubscribers_.unsubscribe(session, book);
+    bookBinarySubscribers_.unsubscribe(session, book);
 }
 
 void
@@ -242,6 +528,7 @@ SubscriptionManager::subBookChanges(std::shared_ptr<WsBase> session)
 
     std::unique_lock lk(cleanupMtx_);
     cleanupFuncs_[session].emplace_back(
+        "book_changes",
         [this](session_ptr session) { unsubBookChanges(session); });
 }
 
@@ -251,6 +538,28 @@ SubscriptionManager::unsubBookChanges(std::shared_ptr<WsBase> session)
     bookChangesSubscribers_.unsubscribe(session);
 }
 
+bool
+SubscriptionManager::resumeStreams(
+    std::shared_ptr<WsBase> session,
+    std::vector<std::string> const& streams,
+    bool binary,
+    std::uint32_t resumeFrom)
+{
+    std::vector<std::pair<std::string, Subscription*>> resumed;
+    for (auto const& stream : streams)
+    {
+        if (stream == "ledger")
+            resumed.emplace_back(stream, &ledgerSubscribers_);
+        else if (stream == "transactions" && binary)
+            resumed.emplace_back("transactions_binary", &txBinarySubscribers_);
+        else if (stream == "transactions")
+            resumed.emplace_back(stream, &txSubscribers_);
+        else if (stream == "book_changes")
+            resumed.emplace_back(stream, &bookChangesSubscribers_);
+    }
+    return history_.resume(resumeFrom, session, resumed);
+}
+
 void
 SubscriptionManager::pubLedger(
     ripple::LedgerInfo const& lgrInfo,
@@ -258,66 +567,169 @@ SubscriptionManager::pubLedger(
     std::string const& ledgerRange,
     std::uint32_t txnCount)
 {
-    auto message = std::make_shared<Message>(boost::json::serialize(
-        getLedgerPubMessage(lgrInfo, fees, ledgerRange, txnCount)));
+    auto message = std::make_shared<Message>(
+        boost::json::serialize(
+            getLedgerPubMessage(lgrInfo, fees, ledgerRange, txnCount)),
+        "ledger");
 
-    ledgerSubscribers_.publish(message);
+    history_.publish("ledger", lgrInfo.seq, message, ledgerSubscribers_);
 }
 
-void
-SubscriptionManager::pubTransaction(
+std::vector<std::optional<ripple::STAmount>>
+SubscriptionManager::fetchOwnerFunds(
+    std::vector<Backend::TransactionAndMetadata> const& transactions,
+    std::uint32_t sequence)
+{
+    std::vector<std::optional<ripple::STAmount>> ownerFunds(
+        transactions.size());
+
+    // owner_funds is the amount the creator of an offer can pay of what the
+    // offer gets, if it is not the issuer of it
+    std::vector<std::size_t> offers;
+    std::vector<std::pair<ripple::STAmount, ripple::AccountID>> requests;
+    for (std::size_t i = 0; i < transactions.size(); ++i)
+    {
+        try
+        {
+            auto const& blob = transactions[i].transaction;
+            ripple::SerialIter it{blob.data(), blob.size()};
+            ripple::STTx tx{it};
+            if (tx.getTxnType() != ripple::ttOFFER_CREATE)
+                continue;
+
+            auto account = tx.getAccountID(ripple::sfAccount);
+            auto amount = tx.getFieldAmount(ripple::sfTakerGets);
+            if (account == amount.issue().account)
+                continue;
+
+            offers.push_back(i);
+            requests.emplace_back(amount, account);
+        }
+        catch (std::exception const& e)
+        {
+            // the message of this transaction fails to build too, and the
+            // error is logged then
+        }
+    }
+    if (requests.empty())
+        return ownerFunds;
+
+    auto funds = Backend::synchronousAndRetryOnTimeout([&](auto yield) {
+        return RPC::accountFundsBatch(*backend_, sequence, requests, yield);
+    });
+    for (std::size_t i = 0; i < offers.size(); ++i)
+        ownerFunds[offers[i]] = funds[i];
+    return ownerFunds;
+}
+
+TransactionAttributes
+getTransactionAttributes(
+    ripple::STTx const& tx,
+    ripple::TxMeta const& meta,
+    std::vector<ripple::Book> const& books)
+{
+    TransactionAttributes attributes{tx.getTxnType(), meta.getResult()};
+    for (auto const field :
+         {&ripple::sfAmount,
+          &ripple::sfSendMax,
+          &ripple::sfDeliverMin,
+          &ripple::sfTakerPays,
+          &ripple::sfTakerGets,
+          &ripple::sfLimitAmount})
+    {
+        if (!tx.isFieldPresent(*field))
+            continue;
+
+        auto const amount = tx.getFieldAmount(*field);
+        if (amount.native())
+            attributes.xrpDrops =
+                std::max(attributes.xrpDrops, amount.xrp().drops());
+        attributes.issues.push_back(amount.issue());
+    }
+
+    for (auto const& book : books)
+    {
+        attributes.issues.push_back(book.in);
+        attributes.issues.push_back(book.out);
+    }
+    return attributes;
+}
+
+SubscriptionManager::TransactionMessage
+SubscriptionManager::buildTransaction(
     Backend::TransactionAndMetadata const& blobs,
-    ripple::LedgerInfo const& lgrInfo)
+    ripple::LedgerInfo const& lgrInfo,
+    std::optional<ripple::STAmount> const& ownerFunds)
 {
     auto [tx, meta] = RPC::deserializeTxPlusMeta(blobs, lgrInfo.seq);
-    boost::json::object pubObj;
-    pubObj["transaction"] = RPC::toJson(*tx);
-    pubObj["meta"] = RPC::toJson(*meta);
-    RPC::insertDeliveredAmount(
-        pubObj["meta"].as_object(), tx, meta, blobs.date);
-    pubObj["type"] = "transaction";
-    pubObj["validated"] = true;
-    pubObj["status"] = "closed";
-
-    pubObj["ledger_index"] = lgrInfo.seq;
-    pubObj["ledger_hash"] = ripple::strHex(lgrInfo.hash);
-    pubObj["transaction"].as_object()["date"] =
-        lgrInfo.closeTime.time_since_epoch().count();
-
-    pubObj["engine_result_code"] = meta->getResult();
+
+    // each format is built only if anyone is subscribed to it, or could
+    // resume from the history
+    bool const json = history_.enabled() || !txSubscribers_.empty() ||
+        accountSubscribers_.count() || bookSubscribers_.count() ||
+        filteredSubscribers_.count();
+    bool const binary = history_.enabled() ||
+        !txBinarySubscribers_.empty() || accountBinarySubscribers_.count() ||
+        bookBinarySubscribers_.count() || filteredBinarySubscribers_.count();
+
     std::string token;
     std::string human;
     ripple::transResultInfo(meta->getResultTER(), token, human);
-    pubObj["engine_result"] = token;
-    pubObj["engine_result_message"] = human;
-    if (tx->getTxnType() == ripple::ttOFFER_CREATE)
-    {
-        auto account = tx->getAccountID(ripple::sfAccount);
-        auto amount = tx->getFieldAmount(ripple::sfTakerGets);
-        if (account != amount.issue().account)
-        {
-            ripple::STAmount ownerFunds;
-            auto fetchFundsSynchronous = [&]() {
-                Backend::synchronous([&](boost::asio::yield_context& yield) {
-                    ownerFunds = RPC::accountFunds(
-                        *backend_, lgrInfo.seq, amount, account, yield);
-                });
-            };
-
-            Backend::retryOnTimeout(fetchFundsSynchronous);
 
+    TransactionMessage built;
+    built.ledgerSequence = lgrInfo.seq;
+    if (json)
+    {
+        boost::json::object pubObj;
+        pubObj["transaction"] = RPC::toJson(*tx);
+        pubObj["meta"] = RPC::toJson(*meta);
+        RPC::insertDeliveredAmount(
+            pubObj["meta"].as_object(), tx, meta, blobs.date);
+        pubObj["type"] = "transaction";
+        pubObj["validated"] = true;
+        pubObj["status"] = "closed";
+
+        pubObj["ledger_index"] = lgrInfo.seq;
+        pubObj["ledger_hash"] = ripple::strHex(lgrInfo.hash);
+        pubObj["transaction"].as_object()["date"] =
+            lgrInfo.closeTime.time_since_epoch().count();
+
+        pubObj["engine_result_code"] = meta->getResult();
+        pubObj["engine_result"] = token;
+        pubObj["engine_result_message"] = human;
+        if (ownerFunds)
             pubObj["transaction"].as_object()["owner_funds"] =
-                ownerFunds.getText();
-        }
+                ownerFunds->getText();
+
+        built.message = std::make_shared<Message>(
+            boost::json::serialize(pubObj), "transactions");
     }
 
-    auto pubMsg = std::make_shared<Message>(boost::json::serialize(pubObj));
-    txSubscribers_.publish(pubMsg);
+    if (binary)
+    {
+        boost::json::object pubObj;
+        pubObj["tx_blob"] = ripple::strHex(blobs.transaction);
+        pubObj["meta"] = ripple::strHex(blobs.metadata);
+        pubObj["hash"] = ripple::strHex(tx->getTransactionID());
+        pubObj["type"] = "transaction";
+        pubObj["validated"] = true;
+        pubObj["status"] = "closed";
+
+        pubObj["ledger_index"] = lgrInfo.seq;
+        pubObj["ledger_hash"] = ripple::strHex(lgrInfo.hash);
+        pubObj["date"] = lgrInfo.closeTime.time_since_epoch().count();
+
+        pubObj["engine_result_code"] = meta->getResult();
+        pubObj["engine_result"] = token;
+        if (ownerFunds)
+            pubObj["owner_funds"] = ownerFunds->getText();
+
+        built.binaryMessage = std::make_shared<Message>(
+            boost::json::serialize(pubObj), "transactions");
+    }
 
     auto accounts = meta->getAffectedAccounts();
-
-    for (auto const& account : accounts)
-        accountSubscribers_.publish(pubMsg, account);
+    built.accounts.assign(accounts.begin(), accounts.end());
 
     std::unordered_set<ripple::Book> alreadySent;
 
@@ -352,13 +764,154 @@ SubscriptionManager::pubTransaction(
                         data->getFieldAmount(ripple::sfTakerPays).issue()};
                     if (alreadySent.find(book) == alreadySent.end())
                     {
-                        bookSubscribers_.publish(pubMsg, book);
+                        built.books.push_back(book);
                         alreadySent.insert(book);
                     }
                 }
             }
         }
     }
+
+    if (filteredSubscribers_.count() || filteredBinarySubscribers_.count())
+        built.attributes = getTransactionAttributes(*tx, *meta, built.books);
+
+    return built;
+}
+
+void
+SubscriptionManager::publishTransaction(TransactionMessage& built)
+{
+    auto publish = [this, &built](
+                       auto& message,
+                       std::string const& stream,
+                       Subscription& txSubscribers,
+                       auto& accountSubscribers,
+                       auto& bookSubscribers) {
+        if (!message)
+            return;
+
+        history_.publish(
+            stream, built.ledgerSequence, message, txSubscribers);
+
+        for (auto const& account : built.accounts)
+            accountSubscribers.publish(message, account);
+
+        for (auto const& book : built.books)
+            bookSubscribers.publish(message, book);
+    };
+
+    publish(
+        built.message,
+        "transactions",
+        txSubscribers_,
+        accountSubscribers_,
+        bookSubscribers_);
+    publish(
+        built.binaryMessage,
+        "transactions_binary",
+        txBinarySubscribers_,
+        accountBinarySubscribers_,
+        bookBinarySubscribers_);
+
+    if (!built.attributes)
+        return;
+
+    std::lock_guard lck{filtersMtx_};
+    for (auto const& [key, group] : filters_)
+    {
+        if (!group.filter.matches(*built.attributes))
+            continue;
+
+        if (built.message)
+            filteredSubscribers_.publish(built.message, key);
+        if (built.binaryMessage)
+            filteredBinarySubscribers_.publish(built.binaryMessage, key);
+    }
+}
+
+void
+SubscriptionManager::pubTransaction(
+    Backend::TransactionAndMetadata const& blobs,
+    ripple::LedgerInfo const& lgrInfo)
+{
+    auto ownerFunds = fetchOwnerFunds({blobs}, lgrInfo.seq);
+    auto built = buildTransaction(blobs, lgrInfo, ownerFunds.front());
+    publishTransaction(built);
+}
+
+void
+SubscriptionManager::pubTransactions(
+    std::vector<Backend::TransactionAndMetadata> const& transactions,
+    ripple::LedgerInfo const& lgrInfo)
+{
+    if (transactions.empty())
+        return;
+
+    auto start = std::chrono::system_clock::now();
+
+    auto ownerFunds = fetchOwnerFunds(transactions, lgrInfo.seq);
+
+    // The messages are built by all of the workers, each taking the next
+    // transaction until none are left. Each message is published as soon as
+    // it and all of the messages before it are built, by whichever worker
+    // built the last of them, so the messages are published in order
+    struct Slot
+    {
+        bool done = false;
+        std::optional<TransactionMessage> built;
+    };
+    std::vector<Slot> slots(transactions.size());
+    std::atomic_size_t next = 0;
+    std::size_t nextToPublish = 0;
+    std::size_t numRunning = std::min(workers_.size(), transactions.size());
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    auto build = [&]() {
+        for (auto i = next++; i < transactions.size(); i = next++)
+        {
+            std::optional<TransactionMessage> built;
+            try
+            {
+                built =
+                    buildTransaction(transactions[i], lgrInfo, ownerFunds[i]);
+            }
+            catch (std::exception const& e)
+            {
+                BOOST_LOG_TRIVIAL(error)
+                    << __func__ << " : failed to build message of transaction "
+                    << i << " of ledger " << lgrInfo.seq << " : " << e.what();
+            }
+
+            std::lock_guard lck{mtx};
+            slots[i] = {true, std::move(built)};
+            for (; nextToPublish < slots.size() && slots[nextToPublish].done;
+                 ++nextToPublish)
+            {
+                if (auto& slot = slots[nextToPublish].built)
+                    publishTransaction(*slot);
+                slots[nextToPublish].built.reset();
+            }
+        }
+
+        std::lock_guard lck{mtx};
+        if (--numRunning == 0)
+            cv.notify_one();
+    };
+
+    for (auto i = numRunning; i > 0; --i)
+        boost::asio::post(ioc_, build);
+
+    std::unique_lock lck{mtx};
+    cv.wait(lck, [&]() { return numRunning == 0; });
+
+    auto end = std::chrono::system_clock::now();
+    BOOST_LOG_TRIVIAL(info)
+        << __func__ << " : published " << transactions.size()
+        << " transactions of ledger " << lgrInfo.seq << " in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
+               .count()
+        << " ms";
 }
 
 void
@@ -366,20 +919,22 @@ SubscriptionManager::pubBookChanges(
     ripple::LedgerInfo const& lgrInfo,
     std::vector<Backend::TransactionAndMetadata> const& transactions)
 {
-    if (bookChangesSubscribers_.empty())
+    if (bookChangesSubscribers_.empty() && !history_.enabled())
         return;
 
     auto const json = RPC::computeBookChanges(lgrInfo, transactions);
-    auto const bookChangesMsg =
-        std::make_shared<Message>(boost::json::serialize(json));
-    bookChangesSubscribers_.publish(bookChangesMsg);
+    auto const bookChangesMsg = std::make_shared<Message>(
+        boost::json::serialize(json), "book_changes");
+    history_.publish(
+        "book_changes", lgrInfo.seq, bookChangesMsg, bookChangesSubscribers_);
 }
 
 void
 SubscriptionManager::forwardProposedTransaction(
     boost::json::object const& response)
 {
-    auto pubMsg = std::make_shared<Message>(boost::json::serialize(response));
+    auto pubMsg = std::make_shared<Message>(
+        boost::json::serialize(response), "transactions_proposed");
     txProposedSubscribers_.publish(pubMsg);
 
     auto transaction = response.at("transaction").as_object();
@@ -392,14 +947,16 @@ SubscriptionManager::forwardProposedTransaction(
 void
 SubscriptionManager::forwardManifest(boost::json::object const& response)
 {
-    auto pubMsg = std::make_shared<Message>(boost::json::serialize(response));
+    auto pubMsg = std::make_shared<Message>(
+        boost::json::serialize(response), "manifests");
     manifestSubscribers_.publish(pubMsg);
 }
 
 void
 SubscriptionManager::forwardValidation(boost::json::object const& response)
 {
-    auto pubMsg = std::make_shared<Message>(boost::json::serialize(response));
+    auto pubMsg = std::make_shared<Message>(
+        boost::json::serialize(response), "validations");
     validationsSubscribers_.publish(pubMsg);
 }
 
@@ -409,6 +966,12 @@ SubscriptionManager::subProposedAccount(
     std::shared_ptr<WsBase> session)
 {
     accountProposedSubscribers_.subscribe(session, account);
+
+    std::unique_lock lk(cleanupMtx_);
+    cleanupFuncs_[session].emplace_back(
+        "transactions_proposed", [this, account](session_ptr session) {
+            unsubProposedAccount(account, session);
+        });
 }
 
 void
@@ -455,6 +1018,42 @@ SubscriptionManager::unsubProposedTransactions(std::shared_ptr<WsBase> session)
     txProposedSubscribers_.unsubscribe(session);
 }
 
+void
+SubscriptionManager::unsubStream(
+    std::string const& stream,
+    std::shared_ptr<WsBase> session)
+{
+    if (stream == "ledger")
+        unsubLedger(session);
+    else if (stream == "transactions")
+        unsubTransactions(session);
+    else if (stream == "transactions_proposed")
+        unsubProposedTransactions(session);
+    else if (stream == "manifests")
+        unsubManifest(session);
+    else if (stream == "validations")
+        unsubValidation(session);
+
+    std::unique_lock lk(cleanupMtx_);
+    auto it = cleanupFuncs_.find(session);
+    if (it == cleanupFuncs_.end())
+        return;
+
+    auto& funcs = it->second;
+    for (auto f = funcs.begin(); f != funcs.end();)
+    {
+        if (f->first == stream)
+        {
+            f->second(session);
+            f = funcs.erase(f);
+        }
+        else
+        {
+            ++f;
+        }
+    }
+}
+
 void
 SubscriptionManager::cleanup(std::shared_ptr<WsBase> session)
 {
@@ -462,7 +1061,7 @@ SubscriptionManager::cleanup(std::shared_ptr<WsBase> session)
     if (!cleanupFuncs_.contains(session))
         return;
 
-    for (auto f : cleanupFuncs_[session])
+    for (auto const& [stream, f] : cleanupFuncs_[session])
     {
         f(session);
     }
@@ -1,8 +1,12 @@
 #ifndef SUBSCRIPTION_MANAGER_H
 #define SUBSCRIPTION_MANAGER_H
 
+#include <ripple/protocol/TxFormats.h>
 #include <backend/BackendInterface.h>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <subscriptions/Message.h>
 
 class WsBase;
@@ -46,23 +50,59 @@ public:
     }
 };
 
+/// Subscribers by key. The sessions are spread over several shards, each
+/// with its own strand, so that publishing to many sessions uses several
+/// threads. All of the subscriptions of a session are in the same shard, so
+/// its messages are sent in the order they were published, whatever their
+/// keys
 template <class Key>
 class SubscriptionMap
 {
     using ptr = std::shared_ptr<WsBase>;
     using subscribers = std::set<ptr>;
 
-    boost::asio::io_context::strand strand_;
-    std::unordered_map<Key, subscribers> subscribers_ = {};
+    struct Shard
+    {
+        boost::asio::io_context::strand strand;
+        std::unordered_map<Key, subscribers> sessions = {};
+
+        explicit Shard(boost::asio::io_context& ioc) : strand(ioc)
+        {
+        }
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
     std::atomic_uint64_t subCount_ = 0;
 
+    // shards with subscribers to each key, so that a message is only posted
+    // to the shards that have a session to send it to
+    std::mutex keysMtx_;
+    std::unordered_map<Key, std::set<std::size_t>> keyShards_;
+
+    std::size_t
+    shardIndex(ptr const& session) const
+    {
+        // sessions are aligned allocations, so the low bits of the address
+        // are mixed into the high ones before picking the shard
+        std::uint64_t const address =
+            reinterpret_cast<std::uintptr_t>(session.get());
+        return ((address * 0x9E3779B97F4A7C15ull) >> 32) % shards_.size();
+    }
+
+    /// Forget a key that has no subscribers left in a shard. Runs on the
+    /// strand of the shard
+    void
+    removeKey(std::size_t index, Key const& key);
+
 public:
     SubscriptionMap() = delete;
     SubscriptionMap(SubscriptionMap&) = delete;
     SubscriptionMap(SubscriptionMap&&) = delete;
 
-    explicit SubscriptionMap(boost::asio::io_context& ioc) : strand_(ioc)
+    SubscriptionMap(boost::asio::io_context& ioc, std::uint64_t numShards)
     {
+        for (auto i = std::max<std::uint64_t>(numShards, 1); i > 0; --i)
+            shards_.push_back(std::make_unique<Shard>(ioc));
     }
 
     ~SubscriptionMap() = default;
@@ -83,6 +123,160 @@ public:
     }
 };
 
+/// Limits on the messages queued for sending to a single session. A session
+/// that goes over either limit is a slow consumer, and is handled according
+/// to the policy
+struct SendQueueLimits
+{
+    enum class Policy {
+        // drop the oldest stream messages until under the limits
+        DROP_OLDEST,
+        // unsubscribe the session from the stream it fell behind on, and
+        // send it a notice
+        DROP_STREAM,
+        // close the connection
+        DISCONNECT
+    };
+
+    std::size_t maxMessages = 10000;
+    std::size_t maxBytes = 64 * 1024 * 1024;
+    Policy policy = Policy::DISCONNECT;
+
+    static SendQueueLimits
+    make_SendQueueLimits(boost::json::object const& config);
+};
+
+/// Send queue metrics, summed over all sessions
+struct SendQueueStats
+{
+    std::atomic_uint64_t queuedMessages = 0;
+    std::atomic_uint64_t queuedBytes = 0;
+    // deepest queue of any session so far
+    std::atomic_uint64_t maxQueuedMessages = 0;
+    std::atomic_uint64_t droppedMessages = 0;
+    std::atomic_uint64_t droppedStreams = 0;
+    std::atomic_uint64_t disconnects = 0;
+
+    void
+    add(std::size_t bytes, std::size_t sessionDepth)
+    {
+        ++queuedMessages;
+        queuedBytes += bytes;
+        auto max = maxQueuedMessages.load();
+        while (sessionDepth > max &&
+               !maxQueuedMessages.compare_exchange_weak(max, sessionDepth))
+            ;
+    }
+
+    void
+    remove(std::size_t bytes)
+    {
+        --queuedMessages;
+        queuedBytes -= bytes;
+    }
+
+    boost::json::object
+    report() const;
+};
+
+/// What transaction filters are evaluated against, computed once per
+/// transaction
+struct TransactionAttributes
+{
+    ripple::TxType type;
+    int result;
+    // largest XRP amount of the amount fields of the transaction
+    std::int64_t xrpDrops = 0;
+    // issues of the amount fields of the transaction, and of the offers it
+    // affected
+    std::vector<ripple::Issue> issues = {};
+};
+
+/// Filter of a subscription to the transactions stream. A transaction
+/// passes if it passes each of the predicates that are set. A predicate
+/// with several values passes if any of them does
+struct TransactionFilter
+{
+    std::vector<ripple::TxType> types = {};
+    std::vector<int> results = {};
+    std::int64_t minXRPDrops = 0;
+    // currency and issuer of any amount involved
+    std::vector<ripple::Issue> issues = {};
+    // currency of any amount involved, whatever the issuer
+    std::vector<ripple::Currency> currencies = {};
+
+    bool
+    matches(TransactionAttributes const& attributes) const;
+
+    /// The same for all equal filters, so that their subscribers are grouped
+    std::string
+    key() const;
+};
+
+/// The messages published to the streams in the last ledgers, so that a
+/// subscriber that missed some can resume from a ledger instead of fetching
+/// them from the database. Holds up to maxLedgers consecutive ledgers, and
+/// nothing if maxLedgers is 0
+class PublishHistory
+{
+    struct Ledger
+    {
+        std::uint32_t sequence;
+        std::unordered_map<std::string, std::vector<std::shared_ptr<Message>>>
+            streams = {};
+    };
+
+    std::mutex mtx_;
+    std::deque<Ledger> ledgers_;
+    std::size_t const maxLedgers_;
+
+    /// contains, with mtx_ already held
+    bool
+    containsLocked(std::uint32_t sequence) const;
+
+public:
+    explicit PublishHistory(std::size_t maxLedgers) : maxLedgers_(maxLedgers)
+    {
+    }
+
+    bool
+    enabled() const
+    {
+        return maxLedgers_ > 0;
+    }
+
+    /// Add a message published to stream in the ledger sequence, and publish
+    /// it to subscribers. Both are done under the lock resume takes, so a
+    /// resuming session gets each message exactly once, from the history or
+    /// live. Ledgers must be added in order. A ledger that is not the one
+    /// after the last clears the history, as the ledgers in between were not
+    /// published
+    void
+    publish(
+        std::string const& stream,
+        std::uint32_t sequence,
+        std::shared_ptr<Message> const& message,
+        Subscription& subscribers);
+
+    /// Whether the history holds every ledger from sequence on, and
+    /// sequence is at most the ledger after the last one published
+    bool
+    contains(std::uint32_t sequence);
+
+    /// For each stream, send session the messages published to it in the
+    /// ledgers from sequence on, then subscribe it to its subscribers. The
+    /// history is checked and all of the streams are replayed under one
+    /// lock, so either every stream is resumed, or none is and false is
+    /// returned because the history does not contain sequence. The replay
+    /// does not count towards the send queue limits of the session, see
+    /// WsBase::sendReplay
+    bool
+    resume(
+        std::uint32_t sequence,
+        std::shared_ptr<WsBase> const& session,
+        std::vector<std::pair<std::string, Subscription*>> const& streams);
+};
+
 class SubscriptionManager
 {
     using session_ptr = std::shared_ptr<WsBase>;
@@ -102,8 +296,33 @@ class SubscriptionManager
     SubscriptionMap<ripple::AccountID> accountProposedSubscribers_;
     SubscriptionMap<ripple::Book> bookSubscribers_;
 
+    // subscribers to transactions as tx_blob and meta, see subscribe's binary
+    Subscription txBinarySubscribers_;
+    SubscriptionMap<ripple::AccountID> accountBinarySubscribers_;
+    SubscriptionMap<ripple::Book> bookBinarySubscribers_;
+
+    // subscribers to filtered transactions, grouped by the key of the filter,
+    // so that each filter is evaluated once per transaction
+    SubscriptionMap<std::string> filteredSubscribers_;
+    SubscriptionMap<std::string> filteredBinarySubscribers_;
+
+    struct FilterGroup
+    {
+        TransactionFilter filter;
+        std::size_t sessions = 0;
+    };
+    std::mutex filtersMtx_;
+    std::unordered_map<std::string, FilterGroup> filters_;
+    std::unordered_map<session_ptr, std::set<std::string>> sessionFilters_;
+
     std::shared_ptr<Backend::BackendInterface const> backend_;
 
+    SendQueueLimits const sendQueueLimits_;
+    std::shared_ptr<SendQueueStats> sendQueueStats_ =
+        std::make_shared<SendQueueStats>();
+
+    PublishHistory history_;
+
 public:
     static std::shared_ptr<SubscriptionManager>
     make_SubscriptionManager(
@@ -118,28 +337,52 @@ public:
             numThreads = config.at("subscription_workers").as_int64();
         }
 
-        return std::make_shared<SubscriptionManager>(numThreads, b);
+        // with a history, every transaction is built both as JSON and as
+        // binary, whoever is subscribed, so that it can be replayed. Off by
+        // default
+        std::size_t historyLedgers = 0;
+        if (config.contains("subscription_history_ledgers") &&
+            config.at("subscription_history_ledgers").is_int64())
+        {
+            historyLedgers =
+                config.at("subscription_history_ledgers").as_int64();
+        }
+
+        return std::make_shared<SubscriptionManager>(
+            numThreads,
+            b,
+            SendQueueLimits::make_SendQueueLimits(config),
+            historyLedgers);
     }
 
     SubscriptionManager(
         std::uint64_t numThreads,
-        std::shared_ptr<Backend::BackendInterface const> const& b)
+        std::shared_ptr<Backend::BackendInterface const> const& b,
+        SendQueueLimits const& sendQueueLimits = {},
+        std::size_t historyLedgers = 0)
         : ledgerSubscribers_(ioc_)
         , txSubscribers_(ioc_)
         , txProposedSubscribers_(ioc_)
         , manifestSubscribers_(ioc_)
         , validationsSubscribers_(ioc_)
         , bookChangesSubscribers_(ioc_)
-        , accountSubscribers_(ioc_)
-        , accountProposedSubscribers_(ioc_)
-        , bookSubscribers_(ioc_)
+        , accountSubscribers_(ioc_, numThreads)
+        , accountProposedSubscribers_(ioc_, numThreads)
+        , bookSubscribers_(ioc_, numThreads)
+        , txBinarySubscribers_(ioc_)
+        , accountBinarySubscribers_(ioc_, numThreads)
+        , bookBinarySubscribers_(ioc_, numThreads)
+        , filteredSubscribers_(ioc_, numThreads)
+        , filteredBinarySubscribers_(ioc_, numThreads)
         , backend_(b)
+        , sendQueueLimits_(sendQueueLimits)
+        , history_(historyLedgers)
     {
         work_.emplace(ioc_);
 
-        // We will eventually want to clamp this to be the number of strands,
-        // since adding more threads than we have strands won't see any
-        // performance benefits
+        // The account and book subscriptions spread their sessions over one
+        // strand per worker, so publishing to many sessions uses all of the
+        // workers. The other streams have a single strand each
         BOOST_LOG_TRIVIAL(info) << "Starting subscription manager with "
                                 << numThreads << " workers";
 
@@ -175,9 +418,19 @@ public:
     void
     unsubLedger(session_ptr session);
 
+    /// Subscribe to all transactions. If binary, they are published as the
+    /// hex of the transaction and metadata blobs, instead of as JSON
     void
-    subTransactions(session_ptr session);
+    subTransactions(session_ptr session, bool binary = false);
 
+    /// Subscribe to the transactions that pass filter
+    void
+    subFilteredTransactions(
+        session_ptr session,
+        TransactionFilter const& filter,
+        bool binary = false);
+
+    /// Unsubscribe from all transactions, filtered or not
     void
     unsubTransactions(session_ptr session);
 
@@ -186,14 +439,28 @@ public:
         Backend::TransactionAndMetadata const& blobs,
         ripple::LedgerInfo const& lgrInfo);
 
+    /// Publish all of the transactions of a ledger. The messages are built in
+    /// parallel by the subscription workers, and published in the order of
+    /// transactions. Returns once all of them are published
     void
-    subAccount(ripple::AccountID const& account, session_ptr& session);
+    pubTransactions(
+        std::vector<Backend::TransactionAndMetadata> const& transactions,
+        ripple::LedgerInfo const& lgrInfo);
+
+    void
+    subAccount(
+        ripple::AccountID const& account,
+        session_ptr& session,
+        bool binary = false);
 
     void
     unsubAccount(ripple::AccountID const& account, session_ptr& session);
 
     void
-    subBook(ripple::Book const& book, session_ptr session);
+    subBook(
+        ripple::Book const& book,
+        session_ptr session,
+        bool binary = false);
 
     void
     unsubBook(ripple::Book const& book, session_ptr session);
@@ -201,6 +468,18 @@ public:
     void
     subBookChanges(std::shared_ptr<WsBase> session);
 
+    /// Subscribe to those of streams that can be resumed, that is ledger,
+    /// transactions and book_changes, after sending session what they
+    /// published from the ledger resumeFrom on. Returns false without
+    /// subscribing to any of them if the history no longer holds all of it.
+    /// Subscribing to them again afterwards does nothing
+    bool
+    resumeStreams(
+        session_ptr session,
+        std::vector<std::string> const& streams,
+        bool binary,
+        std::uint32_t resumeFrom);
+
     void
     unsubBookChanges(std::shared_ptr<WsBase> session);
 
@@ -237,9 +516,27 @@ public:
     void
     unsubProposedTransactions(session_ptr session);
 
+    /// Unsubscribe a session from everything that publishes to stream, the
+    /// stream of a Message. The messages of the transactions stream are also
+    /// published to accounts and books, and so on
+    void
+    unsubStream(std::string const& stream, session_ptr session);
+
     void
     cleanup(session_ptr session);
 
+    SendQueueLimits const&
+    sendQueueLimits() const
+    {
+        return sendQueueLimits_;
+    }
+
+    std::shared_ptr<SendQueueStats>
+    sendQueueStats() const
+    {
+        return sendQueueStats_;
+    }
+
     boost::json::object
     report()
     {
@@ -254,6 +551,16 @@ public:
         counts["accounts_proposed"] = accountProposedSubscribers_.count();
         counts["books"] = bookSubscribers_.count();
         counts["book_changes"] = bookChangesSubscribers_.count();
+        counts["transactions_binary"] = txBinarySubscribers_.count();
+        counts["account_binary"] = accountBinarySubscribers_.count();
+        counts["books_binary"] = bookBinarySubscribers_.count();
+        counts["transactions_filtered"] = filteredSubscribers_.count() +
+            filteredBinarySubscribers_.count();
+        {
+            std::lock_guard lck{filtersMtx_};
+            counts["transaction_filters"] = filters_.size();
+        }
+        counts["send_queue"] = sendQueueStats_->report();
 
         return counts;
     }
@@ -262,15 +569,51 @@ private:
     void
     sendAll(std::string const& pubMsg, std::unordered_set<session_ptr>& subs);
 
+    /// The messages of a transaction, with the accounts and books they are
+    /// published to. Each message is built only if anyone is subscribed to
+    /// its format, or if the history is kept
+    struct TransactionMessage
+    {
+        std::uint32_t ledgerSequence;
+        std::shared_ptr<Message> message;
+        std::shared_ptr<Message> binaryMessage;
+        std::vector<ripple::AccountID> accounts;
+        std::vector<ripple::Book> books;
+        // set only if there are filtered subscribers
+        std::optional<TransactionAttributes> attributes;
+    };
+
+    /// owner_funds of each OfferCreate in transactions that has one. The
+    /// funds of all of them are fetched at once, from the cache if possible
+    std::vector<std::optional<ripple::STAmount>>
+    fetchOwnerFunds(
+        std::vector<Backend::TransactionAndMetadata> const& transactions,
+        std::uint32_t sequence);
+
+    TransactionMessage
+    buildTransaction(
+        Backend::TransactionAndMetadata const& blobs,
+        ripple::LedgerInfo const& lgrInfo,
+        std::optional<ripple::STAmount> const& ownerFunds);
+
+    void
+    publishTransaction(TransactionMessage& built);
+
+    void
+    unsubFilteredTransactions(session_ptr session);
+
     /**
      * This is how we chose to cleanup subscriptions that have been closed.
      * Each time we add a subscriber, we add the opposite lambda that
      * unsubscribes that subscriber when cleanup is called with the session that
-     * closed.
+     * closed. Each lambda is stored with the stream it unsubscribes from, see
+     * unsubStream.
      */
     using CleanupFunction = std::function<void(session_ptr)>;
     std::mutex cleanupMtx_;
-    std::unordered_map<session_ptr, std::vector<CleanupFunction>>
+    std::unordered_map<
+        session_ptr,
+        std::vector<std::pair<std::string, CleanupFunction>>>
         cleanupFuncs_ = {};
 };
 
@@ -8,6 +8,7 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/version.hpp>
+#include <boost/beast/websocket.hpp>
 #include <boost/config.hpp>
 #include <boost/json.hpp>
 #include <algorithm>
@@ -96,6 +97,7 @@ class HttpBase : public util::Taggable
     std::shared_ptr<ReportingETL const> etl_;
     util::TagDecoratorFactory const& tagFactory_;
     DOSGuard& dosGuard_;
+    boost::beast::websocket::permessage_deflate const& deflate_;
     RPC::Counters& counters_;
     WorkQueue& workQueue_;
     send_lambda lambda_;
@@ -152,6 +154,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        boost::beast::websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer buffer)
@@ -163,6 +166,7 @@ public:
         , etl_(etl)
         , tagFactory_(tagFactory)
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , counters_(counters)
         , workQueue_(queue)
         , lambda_(*this)
@@ -225,6 +229,7 @@ public:
                 etl_,
                 tagFactory_,
                 dosGuard_,
+                deflate_,
                 counters_,
                 workQueue_);
         }
@@ -25,6 +25,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        boost::beast::websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer buffer)
@@ -36,6 +37,7 @@ public:
               etl,
               tagFactory,
               dosGuard,
+              deflate,
               counters,
               queue,
               std::move(buffer))
@@ -32,6 +32,7 @@ class Detector
     std::shared_ptr<ReportingETL const> etl_;
     util::TagDecoratorFactory const& tagFactory_;
     DOSGuard& dosGuard_;
+    websocket::permessage_deflate const& deflate_;
     RPC::Counters& counters_;
     WorkQueue& queue_;
     boost::beast::flat_buffer buffer_;
@@ -47,6 +48,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue)
         : ioc_(ioc)
@@ -58,6 +60,7 @@ public:
         , etl_(etl)
         , tagFactory_(tagFactory)
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , counters_(counters)
         , queue_(queue)
     {
@@ -109,6 +112,7 @@ public:
                 etl_,
                 tagFactory_,
                 dosGuard_,
+                deflate_,
                 counters_,
                 queue_,
                 std::move(buffer_))
@@ -126,6 +130,7 @@ public:
             etl_,
             tagFactory_,
             dosGuard_,
+            deflate_,
             counters_,
             queue_,
             std::move(buffer_))
@@ -145,6 +150,7 @@ make_websocket_session(
     std::shared_ptr<ReportingETL const> etl,
     util::TagDecoratorFactory const& tagFactory,
     DOSGuard& dosGuard,
+    websocket::permessage_deflate const& deflate,
     RPC::Counters& counters,
     WorkQueue& queue)
 {
@@ -157,6 +163,7 @@ make_websocket_session(
         etl,
         tagFactory,
         dosGuard,
+        deflate,
         counters,
         queue,
         std::move(buffer),
@@ -176,6 +183,7 @@ make_websocket_session(
     std::shared_ptr<ReportingETL const> etl,
     util::TagDecoratorFactory const& tagFactory,
     DOSGuard& dosGuard,
+    websocket::permessage_deflate const& deflate,
     RPC::Counters& counters,
     WorkQueue& queue)
 {
@@ -188,6 +196,7 @@ make_websocket_session(
         etl,
         tagFactory,
         dosGuard,
+        deflate,
         counters,
         queue,
         std::move(buffer),
@@ -211,6 +220,7 @@ class Listener
     std::shared_ptr<ReportingETL const> etl_;
     util::TagDecoratorFactory tagFactory_;
     DOSGuard& dosGuard_;
+    websocket::permessage_deflate const deflate_;
     WorkQueue queue_;
     RPC::Counters counters_;
 
@@ -226,7 +236,8 @@ public:
         std::shared_ptr<ETLLoadBalancer> balancer,
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory tagFactory,
-        DOSGuard& dosGuard)
+        DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate)
         : ioc_(ioc)
         , ctx_(ctx)
         , acceptor_(net::make_strand(ioc))
@@ -236,6 +247,7 @@ public:
         , etl_(etl)
         , tagFactory_(std::move(tagFactory))
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , queue_(numWorkerThreads, maxQueueSize)
         , counters_(queue_)
     {
@@ -310,6 +322,7 @@ private:
                 etl_,
                 tagFactory_,
                 dosGuard_,
+                deflate_,
                 counters_,
                 queue_)
                 ->run();
@@ -355,6 +368,38 @@ make_HttpServer(
     BOOST_LOG_TRIVIAL(info) << __func__ << " Number of workers = " << numThreads
                             << ". Max queue size = " << maxQueueSize;
 
+    // Each session compresses the messages it sends, so the CPU cost of a
+    // broadcast grows with the number of subscribers that asked for
+    // compression. The default level is the cheapest
+    websocket::permessage_deflate deflate;
+    deflate.compLevel = 1;
+    if (serverConfig.contains("permessage_deflate"))
+    {
+        auto const& deflateConfig =
+            serverConfig.at("permessage_deflate").as_object();
+        deflate.server_enable = true;
+        if (deflateConfig.contains("enabled") &&
+            deflateConfig.at("enabled").is_bool())
+            deflate.server_enable = deflateConfig.at("enabled").as_bool();
+        if (deflateConfig.contains("level") &&
+            deflateConfig.at("level").is_int64())
+            deflate.compLevel = deflateConfig.at("level").as_int64();
+        if (deflateConfig.contains("mem_level") &&
+            deflateConfig.at("mem_level").is_int64())
+            deflate.memLevel = deflateConfig.at("mem_level").as_int64();
+        if (deflateConfig.contains("window_bits") &&
+            deflateConfig.at("window_bits").is_int64())
+            deflate.server_max_window_bits =
+                deflateConfig.at("window_bits").as_int64();
+        if (deflateConfig.contains("no_context_takeover") &&
+            deflateConfig.at("no_context_takeover").is_bool())
+            deflate.server_no_context_takeover =
+                deflateConfig.at("no_context_takeover").as_bool();
+        BOOST_LOG_TRIVIAL(info)
+            << __func__ << " permessage-deflate enabled = "
+            << deflate.server_enable << ". level = " << deflate.compLevel;
+    }
+
     auto server = std::make_shared<HttpServer>(
         ioc,
         numThreads,
@@ -366,7 +411,8 @@ make_HttpServer(
         balancer,
         etl,
         util::TagDecoratorFactory(config),
-        dosGuard);
+        dosGuard,
+        deflate);
 
     server->run();
     return server;
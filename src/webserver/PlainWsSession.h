@@ -38,6 +38,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer&& buffer)
@@ -49,6 +50,7 @@ public:
               etl,
               tagFactory,
               dosGuard,
+              deflate,
               counters,
               queue,
               std::move(buffer))
@@ -95,6 +97,7 @@ class WsUpgrader : public std::enable_shared_from_this<WsUpgrader>
     std::shared_ptr<ReportingETL const> etl_;
     util::TagDecoratorFactory const& tagFactory_;
     DOSGuard& dosGuard_;
+    websocket::permessage_deflate const& deflate_;
     RPC::Counters& counters_;
     WorkQueue& queue_;
     http::request<http::string_body> req_;
@@ -109,6 +112,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer&& b)
@@ -121,6 +125,7 @@ public:
         , etl_(etl)
         , tagFactory_(tagFactory)
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , counters_(counters)
         , queue_(queue)
     {
@@ -134,6 +139,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer&& b,
@@ -147,6 +153,7 @@ public:
         , etl_(etl)
         , tagFactory_(tagFactory)
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , counters_(counters)
         , queue_(queue)
         , req_(std::move(req))
@@ -204,6 +211,7 @@ private:
             etl_,
             tagFactory_,
             dosGuard_,
+            deflate_,
             counters_,
             queue_,
             std::move(buffer_))
@@ -26,6 +26,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        boost::beast::websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer buffer)
@@ -37,6 +38,7 @@ public:
               etl,
               tagFactory,
               dosGuard,
+              deflate,
               counters,
               queue,
               std::move(buffer))
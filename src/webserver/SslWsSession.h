@@ -36,6 +36,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer&& b)
@@ -47,6 +48,7 @@ public:
               etl,
               tagFactory,
               dosGuard,
+              deflate,
               counters,
               queue,
               std::move(b))
@@ -92,6 +94,7 @@ class SslWsUpgrader : public std::enable_shared_from_this<SslWsUpgrader>
     std::shared_ptr<ReportingETL const> etl_;
     util::TagDecoratorFactory const& tagFactory_;
     DOSGuard& dosGuard_;
+    websocket::permessage_deflate const& deflate_;
     RPC::Counters& counters_;
     WorkQueue& queue_;
     http::request<http::string_body> req_;
@@ -107,6 +110,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer&& b)
@@ -119,6 +123,7 @@ public:
         , etl_(etl)
         , tagFactory_(tagFactory)
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , counters_(counters)
         , queue_(queue)
     {
@@ -132,6 +137,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer&& b,
@@ -145,6 +151,7 @@ public:
         , etl_(etl)
         , tagFactory_(tagFactory)
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , counters_(counters)
         , queue_(queue)
         , req_(std::move(req))
@@ -217,6 +224,7 @@ private:
             etl_,
             tagFactory_,
             dosGuard_,
+            deflate_,
             counters_,
             queue_,
             std::move(buffer_))
@@ -4,6 +4,7 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 
+#include <deque>
 #include <iostream>
 #include <memory>
 
@@ -63,6 +64,16 @@ public:
     virtual void
     send(std::shared_ptr<Message> msg) = 0;
 
+    /**
+     * @brief Send messages a stream published before the session subscribed
+     * to it. They do not count towards the send queue limits until they
+     * have left the queue, so that a resuming session is not dropped as a
+     * slow consumer for the size of its replay
+     * @param msgs The messages to send, in order
+     */
+    virtual void
+    sendReplay(std::vector<std::shared_ptr<Message>> msgs) = 0;
+
     virtual ~WsBase() = default;
 
     /**
@@ -101,12 +112,21 @@ class WsSession : public WsBase,
     std::shared_ptr<ReportingETL const> etl_;
     util::TagDecoratorFactory const& tagFactory_;
     DOSGuard& dosGuard_;
+    websocket::permessage_deflate const& deflate_;
     RPC::Counters& counters_;
     WorkQueue& queue_;
     std::mutex mtx_;
 
     bool sending_ = false;
-    std::queue<std::shared_ptr<Message>> messages_;
+    std::deque<std::shared_ptr<Message>> messages_;
+    std::size_t queuedBytes_ = 0;
+    // messages and bytes of replays still queued, which are not counted
+    // towards the limits. Replays are queued before any live message of
+    // their stream, so the next messages to leave the queue are counted off
+    std::size_t replayMessages_ = 0;
+    std::size_t replayBytes_ = 0;
+    SendQueueLimits const sendQueueLimits_;
+    std::shared_ptr<SendQueueStats> sendQueueStats_;
 
     void
     wsFail(boost::beast::error_code ec, char const* what)
@@ -132,6 +152,7 @@ public:
         std::shared_ptr<ReportingETL const> etl,
         util::TagDecoratorFactory const& tagFactory,
         DOSGuard& dosGuard,
+        websocket::permessage_deflate const& deflate,
         RPC::Counters& counters,
         WorkQueue& queue,
         boost::beast::flat_buffer&& buffer)
@@ -144,13 +165,18 @@ public:
         , etl_(etl)
         , tagFactory_(tagFactory)
         , dosGuard_(dosGuard)
+        , deflate_(deflate)
         , counters_(counters)
         , queue_(queue)
+        , sendQueueLimits_(subscriptions->sendQueueLimits())
+        , sendQueueStats_(subscriptions->sendQueueStats())
     {
         BOOST_LOG_TRIVIAL(info) << tag() << "session created";
     }
     virtual ~WsSession()
     {
+        while (!messages_.empty())
+            popMessage(messages_.begin());
         BOOST_LOG_TRIVIAL(info) << tag() << "session closed";
     }
 
@@ -181,12 +207,113 @@ public:
         }
         else
         {
-            messages_.pop();
+            popMessage(messages_.begin());
             sending_ = false;
             maybe_send_next();
         }
     }
 
+    std::deque<std::shared_ptr<Message>>::iterator
+    popMessage(std::deque<std::shared_ptr<Message>>::iterator it)
+    {
+        queuedBytes_ -= (*it)->size();
+        sendQueueStats_->remove((*it)->size());
+        if (replayMessages_)
+        {
+            --replayMessages_;
+            replayBytes_ -= std::min(replayBytes_, (*it)->size());
+        }
+        return messages_.erase(it);
+    }
+
+    bool
+    overLimits() const
+    {
+        return messages_.size() >
+            sendQueueLimits_.maxMessages + replayMessages_ ||
+            queuedBytes_ > sendQueueLimits_.maxBytes + replayBytes_;
+    }
+
+    // Called when the send queue has gone over its limits. The message being
+    // written, if any, is at the front of the queue and is never dropped
+    void
+    onSlowConsumer()
+    {
+        using Policy = SendQueueLimits::Policy;
+
+        auto first = messages_.begin();
+        if (sending_)
+            ++first;
+
+        if (sendQueueLimits_.policy == Policy::DISCONNECT)
+        {
+            ++sendQueueStats_->disconnects;
+            BOOST_LOG_TRIVIAL(warning)
+                << tag() << __func__ << " : disconnecting slow consumer. "
+                << messages_.size() << " messages, " << queuedBytes_
+                << " bytes queued";
+            return wsFail(
+                boost::asio::error::no_buffer_space, "slow consumer");
+        }
+
+        if (sendQueueLimits_.policy == Policy::DROP_OLDEST)
+        {
+            for (auto it = first; it != messages_.end() && overLimits();)
+            {
+                if ((*it)->stream().empty())
+                {
+                    ++it;
+                    continue;
+                }
+                it = popMessage(it);
+                ++sendQueueStats_->droppedMessages;
+            }
+            return;
+        }
+
+        // drop the stream of the newest message. Responses are never
+        // dropped, so if that is a response, drop the stream of the oldest
+        // message instead
+        std::string stream = messages_.back()->stream();
+        for (auto it = first; stream.empty() && it != messages_.end(); ++it)
+            stream = (*it)->stream();
+        if (stream.empty())
+            return;
+
+        for (auto it = first; it != messages_.end();)
+        {
+            if ((*it)->stream() != stream)
+            {
+                ++it;
+                continue;
+            }
+            it = popMessage(it);
+            ++sendQueueStats_->droppedMessages;
+        }
+        ++sendQueueStats_->droppedStreams;
+        BOOST_LOG_TRIVIAL(warning) << tag() << __func__
+                                   << " : dropping stream " << stream
+                                   << " of slow consumer";
+
+        if (auto manager = subscriptions_.lock(); manager)
+            manager->unsubStream(stream, derived().shared_from_this());
+
+        boost::json::object notice;
+        notice["type"] = "streamDropped";
+        notice["stream"] = stream;
+        notice["reason"] = "slowConsumer";
+        pushMessage(
+            std::make_shared<Message>(boost::json::serialize(notice)));
+    }
+
+    void
+    pushMessage(std::shared_ptr<Message> msg)
+    {
+        queuedBytes_ += msg->size();
+        messages_.push_back(std::move(msg));
+        sendQueueStats_->add(messages_.back()->size(), messages_.size());
+    }
+
     void
     maybe_send_next()
     {
@@ -204,7 +331,31 @@ public:
             [this,
              self = derived().shared_from_this(),
              msg = std::move(msg)]() {
-                messages_.push(std::move(msg));
+                if (dead())
+                    return;
+                pushMessage(std::move(msg));
+                if (overLimits())
+                    onSlowConsumer();
+                maybe_send_next();
+            });
+    }
+
+    void
+    sendReplay(std::vector<std::shared_ptr<Message>> msgs) override
+    {
+        net::dispatch(
+            derived().ws().get_executor(),
+            [this,
+             self = derived().shared_from_this(),
+             msgs = std::move(msgs)]() mutable {
+                if (dead())
+                    return;
+                for (auto& msg : msgs)
+                {
+                    ++replayMessages_;
+                    replayBytes_ += msg->size();
+                    pushMessage(std::move(msg));
+                }
                 maybe_send_next();
             });
     }
@@ -232,6 +383,16 @@ public:
                         " websocket-server-async");
             }));
 
+        // permessage-deflate, if enabled in the config and the client asks
+        // for it
+        derived().ws().set_option(deflate_);
+
+        // Send each message as a single frame. Beast splits messages into
+        // frames of write_buffer_bytes by default, each written separately,
+        // which makes most transactions with large metadata take several
+        // writes
+        derived().ws().auto_fragment(false);
+
         derived().ws().async_accept(
             req,
             boost::beast::bind_front_handler(
@@ -1,8 +1,11 @@
 #include <algorithm>
+#include <filesystem>
 #include <backend/DBHelpers.h>
 #include <etl/ReportingETL.h>
 #include <gtest/gtest.h>
 #include <rpc/RPCHelpers.h>
+#include <subscriptions/SubscriptionManager.h>
+#include <webserver/WsBase.h>
 
 #include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
@@ -37,7 +40,18 @@ TEST(BackendTest, Basic)
                     {"max_requests_outstanding", 1000},
                     {"indexer_key_shift", 2},
                     {"threads", 8}}}}}};
-            std::vector<boost::json::object> configs = {cassandraConfig};
+            // same tests, with reads at the latest ledger served from the
+            // latest objects table
+            boost::json::object latestObjectsConfig = cassandraConfig;
+            auto& latestCassandraConfig =
+                latestObjectsConfig.at("database")
+                    .as_object()
+                    .at("cassandra")
+                    .as_object();
+            latestCassandraConfig["keyspace"] = keyspace + "_latest";
+            latestCassandraConfig["latest_objects_table"] = true;
+            std::vector<boost::json::object> configs = {
+                cassandraConfig, latestObjectsConfig};
             for (auto& config : configs)
             {
                 std::cout << keyspace << std::endl;
@@ -1198,6 +1212,8 @@ TEST(Backend, cache)
         auto cacheObj = cache.get(obj.key, curSeq);
         ASSERT_TRUE(cacheObj);
         ASSERT_EQ(*cacheObj, obj.blob);
+        // the cache shares the inserted buffer rather than copying it
+        ASSERT_EQ(cacheObj->data(), obj.blob.data());
         ASSERT_FALSE(cache.get(obj.key, curSeq + 1));
         ASSERT_FALSE(cache.get(obj.key, curSeq - 1));
         ASSERT_FALSE(cache.getSuccessor(obj.key, curSeq));
@@ -1354,7 +1370,7 @@ TEST(Backend, cache)
         if (i % 2 == 0)
             objs[i].blob = {};
         else if (i % 2 == 1)
-            std::reverse(objs[i].blob.begin(), objs[i].blob.end());
+            objs[i].blob = Blob{objs[i].blob.rbegin(), objs[i].blob.rend()};
     }
     cache.update(objs, curSeq);
     {
@@ -1406,6 +1422,32 @@ TEST(Backend, cache)
             ASSERT_EQ(*succ, allObjs[idx++]);
         }
         ASSERT_EQ(idx, allObjs.size());
+
+        // neighbors of present, deleted and unknown keys match the single
+        // key lookups
+        std::vector<ripple::uint256> keys;
+        for (auto& obj : objs)
+            keys.push_back(obj.key);
+        for (auto& obj : objs2)
+            keys.push_back(obj.key);
+        keys.push_back(firstKey);
+        keys.push_back(lastKey);
+        keys.push_back(ripple::uint256{2});
+        std::sort(keys.begin(), keys.end());
+        auto neighbors = cache.getNeighbors(keys, curSeq);
+        ASSERT_EQ(neighbors.size(), keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            auto pred = cache.getPredecessor(keys[i], curSeq);
+            auto succ = cache.getSuccessor(keys[i], curSeq);
+            ASSERT_EQ(neighbors[i].first.has_value(), pred.has_value());
+            if (pred)
+                ASSERT_EQ(*neighbors[i].first, pred->key);
+            ASSERT_EQ(neighbors[i].second.has_value(), succ.has_value());
+            if (succ)
+                ASSERT_EQ(*neighbors[i].second, succ->key);
+        }
+        ASSERT_TRUE(cache.getNeighbors(keys, curSeq - 1).empty());
     }
 }
 
@@ -1452,7 +1494,7 @@ TEST(Backend, cacheBackground)
     }
     for (auto& obj : objs1)
     {
-        std::reverse(obj.blob.begin(), obj.blob.end());
+        obj.blob = Blob{obj.blob.rbegin(), obj.blob.rend()};
     }
     cache.update(objs1, curSeq);
 
@@ -2450,3 +2492,506 @@ TEST(Backend, cacheIntegration)
 
     ioc.run();
 }
+
+TEST(Backend, accountFundsBatch)
+{
+    boost::asio::io_context ioc;
+    std::optional<boost::asio::io_context::work> work;
+    work.emplace(ioc);
+    std::atomic_bool done = false;
+
+    boost::asio::spawn(
+        ioc, [&ioc, &done, &work](boost::asio::yield_context yield) {
+            boost::log::core::get()->set_filter(
+                boost::log::trivial::severity >= boost::log::trivial::warning);
+            std::string keyspace = "clio_test_" +
+                std::to_string(std::chrono::system_clock::now()
+                                   .time_since_epoch()
+                                   .count());
+            boost::json::object config{
+                {"database",
+                 {{"type", "cassandra"},
+                  {"cassandra",
+                   {{"contact_points", "127.0.0.1"},
+                    {"port", 9042},
+                    {"keyspace", keyspace.c_str()},
+                    {"replication_factor", 1},
+                    {"table_prefix", ""},
+                    {"max_requests_outstanding", 1000},
+                    {"indexer_key_shift", 2},
+                    {"threads", 8}}}}}};
+            std::cout << keyspace << std::endl;
+            auto backend = Backend::make_Backend(ioc, config);
+
+            std::string rawHeader =
+                "03C3141A01633CD656F91B4EBB5EB89B791BD34DBC8A04BB6F407C5335"
+                "BC54351E"
+                "DD73"
+                "3898497E809E04074D14D271E4832D7888754F9230800761563A292FA2"
+                "315A6DB6"
+                "FE30"
+                "CC5909B285080FCD6773CC883F9FE0EE4D439340AC592AADB973ED3CF5"
+                "3E2232B3"
+                "3EF5"
+                "7CECAC2816E3122816E31A0A00F8377CD95DFA484CFAE282656A58CE5A"
+                "A29652EF"
+                "FD80"
+                "AC59CD91416E4E13DBBE";
+            auto blob = ripple::strUnHex(rawHeader);
+            std::string rawHeaderBlob{blob->begin(), blob->end()};
+            ripple::LedgerInfo lgrInfo =
+                deserializeHeader(ripple::makeSlice(rawHeaderBlob));
+
+            auto const usd = ripple::to_currency("USD");
+            auto const eur = ripple::to_currency("EUR");
+            // issuer sorts between the holders, so that its trust lines are
+            // on the high side for some of them and on the low side for
+            // the others
+            ripple::AccountID const issuer{10};
+            ripple::AccountID const frozenIssuer{30};
+            ripple::AccountID const alice{1};
+            ripple::AccountID const bob{2};
+            ripple::AccountID const carol{3};
+            ripple::AccountID const dave{4};
+            ripple::AccountID const missing{5};
+            ripple::AccountID const erin{20};
+            ripple::AccountID const frank{21};
+            ripple::AccountID const gina{22};
+
+            auto write = [&](ripple::SLE const& sle) {
+                ripple::Serializer s;
+                sle.add(s);
+                backend->writeLedgerObject(
+                    uint256ToString(sle.key()),
+                    lgrInfo.seq,
+                    std::string{s.peekData().begin(), s.peekData().end()});
+            };
+            auto writeRoot = [&](ripple::AccountID const& id,
+                                 std::uint64_t drops,
+                                 std::uint32_t ownerCount,
+                                 std::uint32_t flags) {
+                ripple::SLE root{ripple::keylet::account(id)};
+                root.setAccountID(ripple::sfAccount, id);
+                root.setFieldAmount(
+                    ripple::sfBalance, ripple::STAmount{drops});
+                root.setFieldU32(ripple::sfOwnerCount, ownerCount);
+                root.setFieldU32(ripple::sfFlags, flags);
+                write(root);
+            };
+            // balance is held by the low account, as on the ledger
+            auto writeLine = [&](ripple::AccountID const& low,
+                                 ripple::AccountID const& high,
+                                 ripple::Currency const& currency,
+                                 ripple::STAmount const& balance,
+                                 std::uint32_t flags) {
+                ripple::SLE line{ripple::keylet::line(low, high, currency)};
+                line.setFieldAmount(ripple::sfBalance, balance);
+                line.setFieldAmount(
+                    ripple::sfLowLimit,
+                    ripple::STAmount{ripple::Issue{currency, low}, 1000});
+                line.setFieldAmount(
+                    ripple::sfHighLimit,
+                    ripple::STAmount{ripple::Issue{currency, high}, 1000});
+                line.setFieldU32(ripple::sfFlags, flags);
+                write(line);
+            };
+            auto lineAmount = [](ripple::Currency const& currency,
+                                 std::int64_t value) {
+                ripple::STAmount amount{
+                    ripple::Issue{currency, ripple::noAccount()},
+                    static_cast<std::uint64_t>(std::abs(value))};
+                return value < 0 ? -amount : amount;
+            };
+
+            backend->startWrites();
+            backend->writeLedger(lgrInfo, std::move(rawHeaderBlob));
+            backend->writeSuccessor(
+                uint256ToString(Backend::firstKey),
+                lgrInfo.seq,
+                uint256ToString(Backend::lastKey));
+
+            ripple::SLE fees{ripple::keylet::fees()};
+            fees.setFieldU64(ripple::sfBaseFee, 10);
+            fees.setFieldU32(ripple::sfReferenceFeeUnits, 10);
+            fees.setFieldU32(ripple::sfReserveBase, 20'000'000);
+            fees.setFieldU32(ripple::sfReserveIncrement, 5'000'000);
+            write(fees);
+
+            writeRoot(issuer, 100'000'000, 0, 0);
+            writeRoot(frozenIssuer, 100'000'000, 0, ripple::lsfGlobalFreeze);
+            writeRoot(alice, 1'000'000'000, 2, 0);
+            // below its reserve
+            writeRoot(bob, 21'000'000, 1, 0);
+            writeLine(alice, issuer, usd, lineAmount(usd, 50), 0);
+            // frozen by the issuer, on the high side
+            writeLine(
+                bob, issuer, usd, lineAmount(usd, 40), ripple::lsfHighFreeze);
+            writeLine(issuer, erin, usd, lineAmount(usd, -70), 0);
+            // frozen by the holder, which does not stop it paying out
+            writeLine(
+                issuer,
+                frank,
+                usd,
+                lineAmount(usd, -60),
+                ripple::lsfHighFreeze);
+            // frozen by the issuer, on the low side
+            writeLine(
+                issuer, gina, usd, lineAmount(usd, -80), ripple::lsfLowFreeze);
+            writeLine(dave, frozenIssuer, eur, lineAmount(eur, 90), 0);
+            ASSERT_TRUE(backend->finishWrites(lgrInfo.seq));
+
+            auto xrp = [](std::uint64_t drops) {
+                return ripple::STAmount{drops};
+            };
+            auto iou = [](ripple::Currency const& currency,
+                          ripple::AccountID const& account,
+                          std::uint64_t value) {
+                return ripple::STAmount{
+                    ripple::Issue{currency, account}, value};
+            };
+            struct Case
+            {
+                ripple::STAmount amount;
+                ripple::AccountID id;
+                ripple::STAmount expected;
+            };
+            std::vector<Case> cases = {
+                // balance less the reserve for two objects
+                {xrp(1), alice, xrp(970'000'000)},
+                {xrp(1), bob, xrp(0)},
+                {xrp(1), missing, xrp(0)},
+                // the issuer holds as much of its own IOU as it offers
+                {iou(usd, issuer, 1234), issuer, iou(usd, issuer, 1234)},
+                {iou(usd, issuer, 1), alice, iou(usd, issuer, 50)},
+                {iou(usd, issuer, 1), bob, iou(usd, issuer, 0)},
+                {iou(usd, issuer, 1), erin, iou(usd, issuer, 70)},
+                {iou(usd, issuer, 1), frank, iou(usd, issuer, 60)},
+                {iou(usd, issuer, 1), gina, iou(usd, issuer, 0)},
+                // no trust line
+                {iou(usd, issuer, 1), carol, iou(usd, issuer, 0)},
+                {iou(eur, frozenIssuer, 1), dave, iou(eur, frozenIssuer, 0)},
+                // repeated requests share their ledger objects
+                {iou(usd, issuer, 1), alice, iou(usd, issuer, 50)},
+                {xrp(1), alice, xrp(970'000'000)}};
+
+            std::vector<std::pair<ripple::STAmount, ripple::AccountID>>
+                requests;
+            for (auto const& c : cases)
+                requests.emplace_back(c.amount, c.id);
+
+            auto funds =
+                RPC::accountFundsBatch(*backend, lgrInfo.seq, requests, yield);
+            ASSERT_EQ(funds.size(), cases.size());
+            for (size_t i = 0; i < cases.size(); ++i)
+            {
+                auto const& c = cases[i];
+                auto single = RPC::accountFunds(
+                    *backend, lgrInfo.seq, c.amount, c.id, yield);
+                EXPECT_EQ(funds[i].getFullText(), single.getFullText()) << i;
+                EXPECT_EQ(funds[i].getFullText(), c.expected.getFullText())
+                    << i;
+            }
+
+            done = true;
+            work.reset();
+        });
+
+    ioc.run();
+    EXPECT_EQ(done, true);
+}
+
+TEST(ETL, markers)
+{
+    // power of 2 markers only differ in the first byte
+    auto markers = getMarkers(256);
+    ASSERT_EQ(markers.size(), 256);
+    for (size_t i = 0; i < markers.size(); ++i)
+    {
+        ripple::uint256 expected{0};
+        expected.data()[0] = i;
+        ASSERT_EQ(markers[i], expected);
+    }
+
+    for (size_t numMarkers : {1, 3, 1000, 65536})
+    {
+        markers = getMarkers(numMarkers);
+        ASSERT_EQ(markers.size(), numMarkers);
+        ASSERT_EQ(markers[0], ripple::uint256{0});
+        for (size_t i = 1; i < markers.size(); ++i)
+            ASSERT_TRUE(markers[i - 1] < markers[i]);
+    }
+
+    auto from = getKeyFromPrefix(10);
+    auto mid = getMidpoint(from, getKeyFromPrefix(20));
+    ASSERT_TRUE(mid);
+    ASSERT_EQ(getKeyPrefix(*mid), 15);
+    ASSERT_FALSE(getMidpoint(from, getKeyFromPrefix(11)));
+    mid = getMidpoint(from, {});
+    ASSERT_TRUE(mid);
+    ASSERT_TRUE(from < *mid);
+}
+
+TEST(ETL, capture)
+{
+    std::string path = "clio_test_capture_" +
+        std::to_string(
+            std::chrono::system_clock::now().time_since_epoch().count());
+    {
+        ETLCapture capture{path};
+        org::xrpl::rpc::v1::GetLedgerResponse ledger;
+        ledger.set_ledger_header("header");
+        capture.write(ETLCapture::RecordType::LEDGER, 11, ledger);
+        org::xrpl::rpc::v1::GetLedgerDataResponse page;
+        page.set_marker("marker");
+        capture.write(ETLCapture::RecordType::LEDGER_DATA, 10, page);
+        capture.write(ETLCapture::RecordType::LEDGER_DATA, 10, page);
+        capture.finishLedgerData(10);
+        // a download that did not complete
+        capture.write(ETLCapture::RecordType::LEDGER_DATA, 9, page);
+    }
+
+    // 5 headers of 17 bytes, then the messages
+    org::xrpl::rpc::v1::GetLedgerResponse written;
+    written.set_ledger_header("header");
+    org::xrpl::rpc::v1::GetLedgerDataResponse writtenPage;
+    writtenPage.set_marker("marker");
+    ASSERT_EQ(
+        std::filesystem::file_size(path),
+        5 * 17 + written.ByteSizeLong() + 3 * writtenPage.ByteSizeLong());
+
+    ETLCaptureReader reader{path};
+    ASSERT_FALSE(reader.hasLedgerData(9));
+    ASSERT_EQ(reader.getFirstSequence(), 10);
+    ASSERT_EQ(reader.getLedgers().size(), 1);
+    ASSERT_FALSE(reader.getLedger(10));
+    org::xrpl::rpc::v1::GetLedgerResponse ledger;
+    ASSERT_TRUE(ledger.ParseFromString(*reader.getLedger(11)));
+    ASSERT_EQ(ledger.ledger_header(), "header");
+    ASSERT_TRUE(reader.hasLedgerData(10));
+    auto pages = reader.getLedgerData(10);
+    ASSERT_EQ(pages.size(), 2);
+    org::xrpl::rpc::v1::GetLedgerDataResponse page;
+    ASSERT_TRUE(page.ParseFromString(pages[1]));
+    ASSERT_EQ(page.marker(), "marker");
+
+    // capturing again overwrites the file
+    {
+        ETLCapture capture{path};
+    }
+    ETLCaptureReader empty{path};
+    ASSERT_FALSE(empty.getFirstSequence());
+    std::remove(path.c_str());
+}
+
+TEST(Subscriptions, filter)
+{
+    auto parse = [](std::string const& json) {
+        return RPC::parseTransactionFilter(
+            boost::json::parse("{\"filter\":" + json + "}").as_object());
+    };
+    auto error = [&](std::string const& json) -> std::string {
+        auto parsed = parse(json);
+        if (auto status = std::get_if<RPC::Status>(&parsed))
+            return status->message;
+        return "";
+    };
+
+    std::string const issuer = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+    ASSERT_EQ(error("[]"), "filterNotObject");
+    ASSERT_EQ(
+        error(R"({"transaction_types":"Payment"})"),
+        "transactionTypesNotArray");
+    ASSERT_EQ(
+        error(R"({"transaction_types":[1]})"), "transactionTypeNotString");
+    ASSERT_EQ(
+        error(R"({"transaction_types":["Foo"]})"), "invalidTransactionType");
+    ASSERT_EQ(
+        error(R"({"engine_results":["tesFOO"]})"), "invalidEngineResult");
+    ASSERT_EQ(error(R"({"min_xrp_drops":-1})"), "minXRPDropsMalformed");
+    ASSERT_EQ(error(R"({"min_xrp_drops":"10"})"), "minXRPDropsMalformed");
+    ASSERT_EQ(error(R"({"currencies":["USD"]})"), "currencyNotObject");
+    ASSERT_EQ(
+        error(R"({"currencies":[{"issuer":")" + issuer + R"("}]})"),
+        "currencyNotString");
+    ASSERT_EQ(
+        error(R"({"currencies":[{"currency":"XRP","issuer":")" + issuer +
+              R"("}]})"),
+        "malformedIssuer");
+    ASSERT_EQ(
+        error(R"({"currencies":[{"currency":"USD","issuer":"bad"}]})"),
+        "malformedIssuer");
+
+    auto filter = [&](std::string const& json) {
+        return std::get<TransactionFilter>(parse(json));
+    };
+
+    ripple::Currency usd;
+    ASSERT_TRUE(ripple::to_currency(usd, "USD"));
+    ripple::Currency eur;
+    ASSERT_TRUE(ripple::to_currency(eur, "EUR"));
+    auto const issuerA = *RPC::accountFromStringStrict(issuer);
+    auto const issuerB = ripple::noAccount();
+
+    TransactionAttributes payment{
+        ripple::ttPAYMENT, ripple::TERtoInt(ripple::tesSUCCESS)};
+
+    // an empty filter passes everything
+    ASSERT_TRUE(filter("{}").matches(payment));
+
+    // transaction type, result and XRP amount. A transaction without a
+    // native amount has 0 drops
+    auto payments = filter(
+        R"({"transaction_types":["Payment"],"engine_results":["tesSUCCESS"],)"
+        R"("min_xrp_drops":100})");
+    ASSERT_FALSE(payments.matches(payment));
+    payment.xrpDrops = 100;
+    ASSERT_TRUE(payments.matches(payment));
+    ASSERT_TRUE(filter(R"({"min_xrp_drops":0})").matches(
+        {ripple::ttOFFER_CREATE, ripple::TERtoInt(ripple::tesSUCCESS)}));
+    ASSERT_FALSE(payments.matches(
+        {ripple::ttOFFER_CREATE, ripple::TERtoInt(ripple::tesSUCCESS), 100}));
+    ASSERT_FALSE(payments.matches(
+        {ripple::ttPAYMENT, ripple::TERtoInt(ripple::tecPATH_DRY), 100}));
+
+    // a currency without issuer matches any issuer, one with an issuer only
+    // that issuer
+    auto anyUSD = filter(R"({"currencies":[{"currency":"USD"}]})");
+    auto usdA = filter(
+        R"({"currencies":[{"currency":"USD","issuer":")" + issuer +
+        R"("}]})");
+    payment.issues = {ripple::Issue{eur, issuerA}};
+    ASSERT_FALSE(anyUSD.matches(payment));
+    ASSERT_FALSE(usdA.matches(payment));
+    payment.issues.push_back(ripple::Issue{usd, issuerB});
+    ASSERT_TRUE(anyUSD.matches(payment));
+    ASSERT_FALSE(usdA.matches(payment));
+    payment.issues.push_back(ripple::Issue{usd, issuerA});
+    ASSERT_TRUE(usdA.matches(payment));
+
+    // equal filters share a key, whatever the order and repetitions of
+    // their values
+    ASSERT_EQ(
+        filter(
+            R"({"transaction_types":["Payment","OfferCreate","Payment"],)"
+            R"("engine_results":["tesSUCCESS"]})")
+            .key(),
+        filter(
+            R"({"engine_results":["tesSUCCESS"],)"
+            R"("transaction_types":["OfferCreate","Payment"]})")
+            .key());
+    ASSERT_NE(
+        filter(R"({"transaction_types":["Payment"]})").key(),
+        filter(R"({"transaction_types":["OfferCreate"]})").key());
+    ASSERT_NE(anyUSD.key(), usdA.key());
+    ASSERT_NE(
+        filter(R"({"min_xrp_drops":1})").key(), filter("{}").key());
+}
+
+TEST(Subscriptions, order)
+{
+    // records the messages sent to it
+    class TestSession : public WsBase
+    {
+        std::mutex mtx_;
+        std::vector<std::string> received_;
+
+    public:
+        explicit TestSession(util::TagDecoratorFactory const& tagFactory)
+            : WsBase(tagFactory)
+        {
+        }
+
+        void
+        send(std::shared_ptr<Message> msg) override
+        {
+            std::lock_guard lck{mtx_};
+            received_.emplace_back(msg->data(), msg->size());
+        }
+
+        void
+        sendReplay(std::vector<std::shared_ptr<Message>> msgs) override
+        {
+            for (auto& msg : msgs)
+                send(msg);
+        }
+
+        std::vector<std::string>
+        received()
+        {
+            std::lock_guard lck{mtx_};
+            return received_;
+        }
+    };
+
+    auto waitFor = [](auto const& done) {
+        for (int i = 0; i < 1000 && !done(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return done();
+    };
+
+    boost::asio::io_context ioc;
+    std::optional<boost::asio::io_context::work> work;
+    work.emplace(ioc);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i)
+        workers.emplace_back([&ioc] { ioc.run(); });
+
+    std::size_t const numShards = 8;
+    SubscriptionMap<ripple::AccountID> accounts{ioc, numShards};
+
+    // two accounts that would be on different strands if the map was
+    // sharded by key
+    auto keyShard = [&](ripple::AccountID const& account) {
+        return std::hash<ripple::AccountID>{}(account) % numShards;
+    };
+    ripple::AccountID const alice{1};
+    ripple::AccountID bob{2};
+    for (std::uint64_t i = 3; keyShard(bob) == keyShard(alice); ++i)
+        bob = ripple::AccountID{i};
+
+    util::TagDecoratorFactory tagFactory{boost::json::object{}};
+    std::vector<std::shared_ptr<TestSession>> sessions;
+    for (int i = 0; i < 16; ++i)
+    {
+        sessions.push_back(std::make_shared<TestSession>(tagFactory));
+        accounts.subscribe(sessions.back(), alice);
+        accounts.subscribe(sessions.back(), bob);
+    }
+    ASSERT_TRUE(waitFor([&] { return accounts.count() == 32; }));
+
+    // consecutive transactions, alternately affecting each account
+    std::size_t const numMessages = 2000;
+    for (std::size_t i = 0; i < numMessages; ++i)
+    {
+        auto message = std::make_shared<Message>(std::to_string(i));
+        accounts.publish(message, i % 2 ? bob : alice);
+    }
+
+    for (auto const& session : sessions)
+    {
+        ASSERT_TRUE(waitFor(
+            [&] { return session->received().size() == numMessages; }));
+        auto const received = session->received();
+        for (std::size_t i = 0; i < numMessages; ++i)
+            ASSERT_EQ(received[i], std::to_string(i));
+    }
+
+    // a session that unsubscribes from one account keeps the other
+    accounts.unsubscribe(sessions.front(), alice);
+    ASSERT_TRUE(waitFor([&] { return accounts.count() == 31; }));
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        auto message = std::make_shared<Message>("after" + std::to_string(i));
+        accounts.publish(message, i % 2 ? bob : alice);
+    }
+    ASSERT_TRUE(waitFor(
+        [&] { return sessions.back()->received().size() == numMessages + 2; }));
+    ASSERT_TRUE(waitFor([&] {
+        return sessions.front()->received().size() == numMessages + 1;
+    }));
+    ASSERT_EQ(sessions.front()->received().back(), "after1");
+
+    work.reset();
+    for (auto& worker : workers)
+        worker.join();
+}